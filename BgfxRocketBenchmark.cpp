@@ -0,0 +1,597 @@
+// Headless benchmark for RocketBgfxInterface.
+// bgfx runs with the Null renderer, so this needs no GPU or window and measures only the CPU side of the integration:
+// libRocket layout and geometry generation, our batching and uploads, and bgfx's submission. Every scene is run three
+// times: through compiled geometry, with CompileGeometry disabled so libRocket falls back to RenderGeometry, and with
+// libRocket on a thread of its own, decoupled from the bgfx thread.
+//
+//   BgfxRocketBenchmark [--frames N] [--elements N] [--shaders DIR] [--scene NAME] [--texture-budget BYTES]
+//                       [--upload-budget BYTES] [--bundle FILE]
+//
+// Run it from the repository root so data/ and assets/ resolve. --shaders loads the compiled programs
+// (vs_BgfxRocketRenderTest.bin, vs_BgfxRocketRenderTestInstanced.bin, fs_BgfxRocketRenderTestColor.bin,
+// fs_BgfxRocketRenderTestTexture.bin, fs_BgfxRocketRenderTestAlpha.bin, fs_BgfxRocketRenderTestDistance.bin) and
+// enables instancing of repeated compiled geometry and single-channel glyph pages; without them the draws are submitted
+// with invalid programs, which the Null renderer never executes anyway. --texture-budget and --upload-budget run every
+// interface with that texture residency and per-frame upload budget, see RocketBgfxInterface::setTextureBudget.
+//
+// Startup is timed first: libRocket's initialisation with the fonts, then a fresh interface loading data/test.rml and
+// drawing its first frame. --bundle serves all of it from a bundle written by BgfxRocketBundleTool, e.g.
+//   BgfxRocketBundleTool --output ui.bundle data/test.rml assets/*.otf
+// so running once with and once without it compares the two. Drop the OS file cache before each run for a cold start.
+//
+// After the scenes, images are loaded during frames with the loader threads off and on, for the frame time spikes
+// decoding causes. Last, a capture is replayed and checked, see checkCaptureReplay(); a failure makes the exit code 1.
+
+#include "RocketBgfxBundleFileInterface.hpp"
+#include "RocketBgfxInterface.hpp"
+
+#include <bgfx.h>
+#include <Rocket/Core.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Every allocation in the process is counted, libRocket's included. bgfx allocates through its own allocator, what the
+// interface hands it shows in the copied (bgfx::copy/alloc) and referenced (bgfx::makeRef) columns instead.
+static std::atomic<uint64_t> s_allocations(0);
+static std::atomic<uint64_t> s_allocatedBytes(0);
+
+void * operator new(size_t size) {
+    s_allocations++;
+    s_allocatedBytes += size;
+    if (void * p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void * operator new[](size_t size) {
+    return operator new(size);
+}
+void operator delete(void * p) noexcept {
+    std::free(p);
+}
+void operator delete[](void * p) noexcept {
+    std::free(p);
+}
+void operator delete(void * p, size_t) noexcept {
+    std::free(p);
+}
+void operator delete[](void * p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+    const int WIDTH = 1280;
+    const int HEIGHT = 720;
+
+    double elapsedMs(std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+    }
+
+    class BenchmarkSystemInterface : public Rocket::Core::SystemInterface
+    {
+    public:
+        BenchmarkSystemInterface() : _start(std::chrono::steady_clock::now()) {}
+        virtual float GetElapsedTime() override { return static_cast<float>(elapsedMs(_start) / 1000.0); }
+    private:
+        std::chrono::steady_clock::time_point _start;
+    };
+
+    // Declining to compile makes libRocket re-send its geometry through RenderGeometry every frame
+    class DynamicOnlyInterface : public RocketBgfxInterface
+    {
+    public:
+        using RocketBgfxInterface::RocketBgfxInterface;
+        virtual Rocket::Core::CompiledGeometryHandle CompileGeometry(Rocket::Core::Vertex*, int, int*, int, Rocket::Core::TextureHandle) override { return 0; }
+    };
+
+    bgfx::ShaderHandle loadShader(const std::string & path) {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (data.empty()) {
+            std::fprintf(stderr, "Can't read shader %s\n", path.c_str());
+            return BGFX_INVALID_HANDLE;
+        }
+        return bgfx::createShader(bgfx::copy(data.data(), static_cast<uint32_t>(data.size())));
+    }
+    bgfx::ProgramHandle loadProgram(const std::string & dir, const char * vertex, const char * fragment) {
+        bgfx::ShaderHandle vs = loadShader(dir + "/" + vertex + ".bin");
+        bgfx::ShaderHandle fs = loadShader(dir + "/" + fragment + ".bin");
+        if (!bgfx::isValid(vs) || !bgfx::isValid(fs))
+            return BGFX_INVALID_HANDLE;
+        return bgfx::createProgram(vs, fs, true);
+    }
+
+    // Stress documents, sized by --elements
+    std::string documentHead() {
+        return "<rml><head><style>"
+            "body { font-family: Delicious; font-size: 14; color: black; width: 100%; height: 100%; }"
+            ".box { display: inline-block; width: 40px; height: 18px; margin: 1px; background-color: #4060a0;"
+            "       border: 1px #203050; color: white; }"
+            ".panel { display: inline-block; width: 300px; height: 160px; margin: 4px; overflow: auto;"
+            "         background-color: #e0e0e0; border: 1px #808080; }"
+            ".row { display: block; height: 16px; }"
+            "</style></head><body>";
+    }
+    std::string boxesDocument(int elements) {
+        std::string rml = documentHead();
+        for (int i = 0; i < elements; ++i) {
+            rml += "<div class=\"box\"></div>";
+        }
+        return rml + "</body></rml>";
+    }
+    std::string textDocument(int elements) {
+        std::string rml = documentHead();
+        for (int i = 0; i < elements; ++i) {
+            rml += "<p>Text run " + std::to_string(i) + ": the quick brown fox jumps over the lazy dog</p>";
+        }
+        return rml + "</body></rml>";
+    }
+    std::string scrollDocument(int elements) {
+        std::string rml = documentHead();
+        const int panels = std::max(1, elements / 100);
+        for (int panel = 0; panel < panels; ++panel) {
+            rml += "<div class=\"panel\" id=\"panel" + std::to_string(panel) + "\">";
+            for (int row = 0; row < 100; ++row) {
+                rml += "<div class=\"row\">Panel " + std::to_string(panel) + " row " + std::to_string(row) + "</div>";
+            }
+            rml += "</div>";
+        }
+        return rml + "</body></rml>";
+    }
+
+    struct Scene {
+        const char * name;
+        std::string  rml;           // loaded from memory, unless path is set
+        const char * path;
+        int          scrollPanels;  // panels scrolled a little every frame
+    };
+
+    struct Result {
+        double   meanMs, p50Ms, p99Ms, maxMs;
+        double   allocationsPerFrame, allocatedBytesPerFrame;
+        double   drawsPerFrame, bytesCopiedPerFrame, bytesReferencedPerFrame;
+    };
+
+    double percentile(std::vector<double> sorted, double fraction) {
+        std::sort(sorted.begin(), sorted.end());
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()))];
+    }
+
+    Result summarize(const std::vector<double> & times, uint64_t allocations, uint64_t allocatedBytes, uint64_t draws, uint64_t bytesCopied,
+        uint64_t bytesReferenced)
+    {
+        const double frames = double(times.size());
+        Result result;
+        double total = 0.0;
+        for (double time : times) total += time;
+        result.meanMs = total / frames;
+        result.p50Ms = percentile(times, 0.5);
+        result.p99Ms = percentile(times, 0.99);
+        result.maxMs = *std::max_element(times.begin(), times.end());
+        result.allocationsPerFrame = double(allocations) / frames;
+        result.allocatedBytesPerFrame = double(allocatedBytes) / frames;
+        result.drawsPerFrame = double(draws) / frames;
+        result.bytesCopiedPerFrame = double(bytesCopied) / frames;
+        result.bytesReferencedPerFrame = double(bytesReferenced) / frames;
+        return result;
+    }
+
+    Rocket::Core::ElementDocument * loadScene(const Scene & scene, Rocket::Core::Context * context) {
+        Rocket::Core::ElementDocument * document = scene.path
+            ? context->LoadDocument(scene.path)
+            : context->LoadDocumentFromMemory(scene.rml.c_str());
+        if (document) {
+            document->Show();
+            document->RemoveReference();
+        }
+        return document;
+    }
+    void scrollScene(const Scene & scene, Rocket::Core::ElementDocument * document, int frame) {
+        for (int panel = 0; panel < scene.scrollPanels; ++panel) {
+            Rocket::Core::Element * element = document ? document->GetElementById(("panel" + std::to_string(panel)).c_str()) : nullptr;
+            if (element) {
+                element->SetScrollTop(static_cast<float>((frame * 3) % 1200));
+            }
+        }
+    }
+
+    // A document opened by a fresh interface, until its first frame is handed to bgfx: reading the RML and what it
+    // links, layout, loading its images and uploading everything
+    double measureFirstFrame(const RocketBgfxBundle * bundle, bgfx::ProgramHandle colorShader, bgfx::ProgramHandle textureShader) {
+        RocketBgfxInterface ui(0, colorShader, textureShader, float(WIDTH), float(HEIGHT));
+        ui.setAssetBundle(bundle);
+
+        const auto start = std::chrono::steady_clock::now();
+        Rocket::Core::Context * context = Rocket::Core::CreateContext("startup", Rocket::Core::Vector2i(WIDTH, HEIGHT), &ui);
+        Rocket::Core::ElementDocument * document = context->LoadDocument("data/test.rml");
+        if (document) {
+            document->Show();
+            document->RemoveReference();
+        }
+        context->Update();
+        context->Render();
+        ui.frame();
+        bgfx::frame();
+        const double ms = elapsedMs(start);
+
+        context->RemoveReference();
+        Rocket::Core::ReleaseTextures();
+        for (int frame = 0; frame < 4; ++frame) {
+            ui.frame();
+            bgfx::frame();
+        }
+        return ms;
+    }
+
+    // Warm up so one-time work (font glyph pages, first compile) doesn't dominate
+    const int WARMUP_FRAMES = 5;
+
+    // Frame time covers everything our integration is involved in: libRocket's update and render calls into the
+    // interface, frame()'s submission and bgfx::frame() consuming it.
+    Result runScene(const Scene & scene, RocketBgfxInterface & ui, int frames) {
+        Rocket::Core::Context * context = Rocket::Core::CreateContext(scene.name, Rocket::Core::Vector2i(WIDTH, HEIGHT), &ui);
+        Rocket::Core::ElementDocument * document = loadScene(scene, context);
+
+        for (int frame = 0; frame < WARMUP_FRAMES; ++frame) {
+            context->Update();
+            context->Render();
+            ui.frame();
+            bgfx::frame();
+        }
+
+        std::vector<double> times;
+        times.reserve(frames);
+        const uint64_t allocations = s_allocations;
+        const uint64_t allocatedBytes = s_allocatedBytes;
+        uint64_t draws = 0, bytesCopied = 0, bytesReferenced = 0;
+
+        for (int frame = 0; frame < frames; ++frame) {
+            scrollScene(scene, document, frame);
+
+            const auto start = std::chrono::steady_clock::now();
+            context->Update();
+            context->Render();
+            ui.frame();
+            bgfx::frame();
+            times.push_back(elapsedMs(start));
+
+            draws += ui.getFrameStats().drawCalls;
+            bytesCopied += ui.getFrameStats().bytesCopied;
+            bytesReferenced += ui.getFrameStats().bytesReferenced;
+        }
+
+        const Result result = summarize(times, s_allocations - allocations, s_allocatedBytes - allocatedBytes, draws, bytesCopied, bytesReferenced);
+
+        context->RemoveReference();
+        // Let the interface retire what the context released
+        for (int frame = 0; frame < 4; ++frame) {
+            ui.frame();
+            bgfx::frame();
+        }
+        return result;
+    }
+
+    // libRocket updates and renders on a thread of its own while this one draws the frame before, see
+    // RocketBgfxInterface::setDecoupledRecording. Frame time is the interval between frames handed to bgfx, and every
+    // committed frame is drawn exactly once, so draws per frame must match the compiled run.
+    Result runDecoupledScene(const Scene & scene, RocketBgfxInterface & ui, int frames) {
+        ui.setDecoupledRecording(true);
+
+        std::thread rocket([&] {
+            Rocket::Core::Context * context = Rocket::Core::CreateContext(scene.name, Rocket::Core::Vector2i(WIDTH, HEIGHT), &ui);
+            Rocket::Core::ElementDocument * document = loadScene(scene, context);
+            for (int frame = 0; frame < WARMUP_FRAMES + frames; ++frame) {
+                scrollScene(scene, document, frame - WARMUP_FRAMES);
+                context->Update();
+                context->Render();
+                ui.commitFrame();
+            }
+            context->RemoveReference();
+            ui.commitFrame();
+        });
+
+        std::vector<double> times;
+        times.reserve(frames);
+        uint64_t allocations = 0, allocatedBytes = 0;
+        uint64_t draws = 0, bytesCopied = 0, bytesReferenced = 0;
+
+        // A frame is only ever committed once the one before it was picked up, so each frame() below draws the
+        // frame with the number it saw
+        uint64_t drawn = 0;
+        auto last = std::chrono::steady_clock::now();
+        while (drawn < uint64_t(WARMUP_FRAMES + frames + 1)) {
+            const uint64_t committed = ui.getFramesCommitted();
+            if (committed == drawn) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            ui.frame();
+            bgfx::frame();
+            drawn = committed;
+
+            if (drawn == uint64_t(WARMUP_FRAMES)) {
+                allocations = s_allocations;
+                allocatedBytes = s_allocatedBytes;
+            }
+            else if (drawn > uint64_t(WARMUP_FRAMES) && drawn <= uint64_t(WARMUP_FRAMES + frames)) {
+                times.push_back(elapsedMs(last));
+                draws += ui.getFrameStats().drawCalls;
+                bytesCopied += ui.getFrameStats().bytesCopied;
+                bytesReferenced += ui.getFrameStats().bytesReferenced;
+            }
+            last = std::chrono::steady_clock::now();
+        }
+        rocket.join();
+
+        return summarize(times, s_allocations - allocations, s_allocatedBytes - allocatedBytes, draws, bytesCopied, bytesReferenced);
+    }
+
+    // Churn through handle tables the way Rocket uses them: a live working set that is looked up every frame while a
+    // fraction of it is released and recreated. Compares RocketBgfxSlotMap with the unordered_map it replaced.
+    template <typename Insert, typename Find, typename Erase>
+    double churnHandles(Insert insert, Find find, Erase erase, int live, int rounds) {
+        std::vector<uint32_t> handles;
+        for (int i = 0; i < live; ++i) handles.push_back(insert(i));
+
+        const auto start = std::chrono::steady_clock::now();
+        uint64_t sum = 0;
+        uint32_t seed = 1;
+        for (int round = 0; round < rounds; ++round) {
+            for (uint32_t handle : handles) sum += find(handle);
+            for (int i = 0; i < live / 10; ++i) {
+                seed = seed * 1664525u + 1013904223u;
+                uint32_t & handle = handles[seed % handles.size()];
+                erase(handle);
+                handle = insert(round);
+            }
+        }
+        const double ms = elapsedMs(start);
+        if (sum == 42) std::printf(" ");   // keep the lookups alive
+        return ms;
+    }
+    void benchmarkHandleTables() {
+        const int live = 20000, rounds = 200;
+
+        RocketBgfxSlotMap<uint64_t> slotMap;
+        const double slotMapMs = churnHandles(
+            [&](int value) { return slotMap.insert(uint64_t(value)); },
+            [&](uint32_t handle) { return *slotMap.find(handle); },
+            [&](uint32_t handle) { slotMap.erase(handle); },
+            live, rounds);
+
+        std::unordered_map<uint32_t, uint64_t> hashMap;
+        uint32_t nextKey = 1;
+        const double hashMapMs = churnHandles(
+            [&](int value) { hashMap[nextKey] = uint64_t(value); return nextKey++; },
+            [&](uint32_t handle) { return hashMap.find(handle)->second; },
+            [&](uint32_t handle) { hashMap.erase(handle); },
+            live, rounds);
+
+        std::printf("\nhandle tables, %d live handles x %d rounds (find all, replace 10%%)\n", live, rounds);
+        std::printf("  RocketBgfxSlotMap          %8.2f ms\n", slotMapMs);
+        std::printf("  std::unordered_map         %8.2f ms\n", hashMapMs);
+    }
+
+    // Images opened while frames are running, the way a document revealing new content loads them: a burst of new
+    // sources every tenth frame. Decoded inside LoadTexture they stall the frame that asks for them, the loader
+    // threads take the decode off it. Every spelling of the path is a new cache key, so every load decodes again.
+    void benchmarkTextureLoading(bgfx::ProgramHandle colorShader, bgfx::ProgramHandle textureShader) {
+        const int frames = 60, burst = 2;
+        std::printf("\ntexture loading, %d frames, %d loads of screenshot1.png every 10th frame\n", frames, burst);
+
+        const unsigned loaderThreads[] = { 0, 2 };
+        for (unsigned threads : loaderThreads) {
+            RocketBgfxInterface ui(0, colorShader, textureShader, float(WIDTH), float(HEIGHT));
+            ui.setTextureLoaderThreads(threads);
+
+            std::vector<Rocket::Core::TextureHandle> textures;
+            std::vector<double> times;
+            std::string path = "screenshot1.png";
+            for (int frame = 0; frame < frames; ++frame) {
+                const auto start = std::chrono::steady_clock::now();
+                for (int load = 0; frame % 10 == 0 && load < burst; ++load) {
+                    path = "./" + path;
+                    Rocket::Core::TextureHandle texture;
+                    Rocket::Core::Vector2i dimensions;
+                    if (ui.LoadTexture(texture, dimensions, path.c_str())) textures.push_back(texture);
+                }
+                ui.frame();
+                bgfx::frame();
+                times.push_back(elapsedMs(start));
+            }
+
+            while (ui.getPendingTextureLoads()) {
+                ui.frame();
+                bgfx::frame();
+            }
+            for (Rocket::Core::TextureHandle texture : textures) ui.ReleaseTexture(texture);
+            ui.frame();
+            bgfx::frame();
+
+            const Result result = summarize(times, 0, 0, 0, 0, 0);
+            std::printf("  loader threads %u   mean %8.3f ms   p99 %8.3f ms   worst frame %8.3f ms\n", threads, result.meanMs, result.p99Ms, result.maxMs);
+        }
+    }
+
+    // Round trip of shared compiled geometry through a capture. The recording interface answers two identical compiles
+    // with one handle, so the capture holds two CompileGeometry records for it. Replayed, the first release must leave
+    // the geometry drawable and the second must free it.
+    bool checkCaptureReplay(bgfx::ProgramHandle colorShader, bgfx::ProgramHandle textureShader) {
+        const char * path = "BgfxRocketBenchmark.capture";
+        std::vector<Rocket::Core::Vertex> quad(4);
+        for (int i = 0; i < 4; ++i) {
+            quad[i].position = Rocket::Core::Vector2f(float(i & 1) * 10.0f, float(i >> 1) * 10.0f);
+            quad[i].colour = Rocket::Core::Colourb(255, 255, 255, 255);
+        }
+        int indices[6] = { 0, 1, 2, 1, 3, 2 };
+        {
+            RocketBgfxInterface recording(0, colorShader, textureShader, float(WIDTH), float(HEIGHT));
+            if (!recording.startCapture(path)) {
+                std::fprintf(stderr, "Can't write capture %s\n", path);
+                return false;
+            }
+            const Rocket::Core::CompiledGeometryHandle first = recording.CompileGeometry(quad.data(), 4, indices, 6, 0);
+            const Rocket::Core::CompiledGeometryHandle second = recording.CompileGeometry(quad.data(), 4, indices, 6, 0);
+            recording.ReleaseCompiledGeometry(first);
+            recording.RenderCompiledGeometry(second, Rocket::Core::Vector2f(0.0f, 0.0f));
+            recording.frame();
+            recording.ReleaseCompiledGeometry(second);
+            recording.frame();
+            recording.stopCapture();
+            bgfx::frame();
+        }
+
+        RocketBgfxInterface replaying(0, colorShader, textureShader, float(WIDTH), float(HEIGHT));
+        RocketBgfxCaptureReplayer replayer(path);
+        replayer.replayFrame(replaying);
+        replaying.frame();
+        bgfx::frame();
+        const uint32_t drawn = replaying.getFrameStats().drawCalls;
+        const uint32_t liveAfterFirst = replaying.getCompiledGeometryStats().allocations;
+        replayer.replayFrame(replaying);
+        replaying.frame();
+        bgfx::frame();
+        const uint32_t liveAfterSecond = replaying.getCompiledGeometryStats().allocations;
+        std::remove(path);
+
+        const bool passed = replayer.isOpen() && drawn == 1 && liveAfterFirst == 1 && liveAfterSecond == 0;
+        std::printf("\ncapture replay of shared compiled geometry: %s (drawn %u, live after one release %u, after both %u)\n",
+            passed ? "ok" : "FAILED", drawn, liveAfterFirst, liveAfterSecond);
+        return passed;
+    }
+}
+
+int main(int argc, char ** argv) {
+    int frames = 300;
+    int elements = 2000;
+    std::string shaders;
+    std::string only;
+    uint64_t textureBudget = 0, uploadBudget = 0;
+    std::string bundlePath;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string arg = argv[i];
+        if (arg == "--frames") frames = std::max(1, std::atoi(argv[i + 1]));
+        else if (arg == "--elements") elements = std::max(1, std::atoi(argv[i + 1]));
+        else if (arg == "--shaders") shaders = argv[i + 1];
+        else if (arg == "--scene") only = argv[i + 1];
+        else if (arg == "--texture-budget") textureBudget = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (arg == "--upload-budget") uploadBudget = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (arg == "--bundle") bundlePath = argv[i + 1];
+        else {
+            std::fprintf(stderr, "Unknown argument %s\n", arg.c_str());
+            return 1;
+        }
+    }
+
+    bgfx::init(bgfx::RendererType::Null);
+    bgfx::reset(WIDTH, HEIGHT, BGFX_RESET_NONE);
+
+    bgfx::ProgramHandle colorShader = BGFX_INVALID_HANDLE, textureShader = BGFX_INVALID_HANDLE;
+    bgfx::ProgramHandle colorInstancedShader = BGFX_INVALID_HANDLE, textureInstancedShader = BGFX_INVALID_HANDLE;
+    bgfx::ProgramHandle alphaShader = BGFX_INVALID_HANDLE, distanceFieldShader = BGFX_INVALID_HANDLE;
+    if (!shaders.empty()) {
+        colorShader = loadProgram(shaders, "vs_BgfxRocketRenderTest", "fs_BgfxRocketRenderTestColor");
+        textureShader = loadProgram(shaders, "vs_BgfxRocketRenderTest", "fs_BgfxRocketRenderTestTexture");
+        colorInstancedShader = loadProgram(shaders, "vs_BgfxRocketRenderTestInstanced", "fs_BgfxRocketRenderTestColor");
+        textureInstancedShader = loadProgram(shaders, "vs_BgfxRocketRenderTestInstanced", "fs_BgfxRocketRenderTestTexture");
+        alphaShader = loadProgram(shaders, "vs_BgfxRocketRenderTest", "fs_BgfxRocketRenderTestAlpha");
+        distanceFieldShader = loadProgram(shaders, "vs_BgfxRocketRenderTest", "fs_BgfxRocketRenderTestDistance");
+    }
+
+    // The bundle is opened inside the timed startup, it is part of what a bundled application pays for
+    const auto startupBegin = std::chrono::steady_clock::now();
+    RocketBgfxBundle bundle;
+    std::unique_ptr<RocketBgfxBundleFileInterface> bundleFiles;
+    if (!bundlePath.empty()) {
+        std::string error;
+        if (!bundle.open(bundlePath, error)) {
+            std::fprintf(stderr, "Can't open bundle %s: %s\n", bundlePath.c_str(), error.c_str());
+            return 1;
+        }
+        bundleFiles.reset(new RocketBgfxBundleFileInterface(bundle));
+        Rocket::Core::SetFileInterface(bundleFiles.get());
+    }
+
+    BenchmarkSystemInterface system;
+    Rocket::Core::SetSystemInterface(&system);
+    Rocket::Core::Initialise();
+    const char * fonts[] = { "assets/Delicious-Roman.otf", "assets/Delicious-Bold.otf", "assets/Delicious-Italic.otf", "assets/Delicious-BoldItalic.otf" };
+    for (const char * font : fonts) {
+        Rocket::Core::FontDatabase::LoadFontFace(font);
+    }
+    const double initialiseMs = elapsedMs(startupBegin);
+    const double firstFrameMs = measureFirstFrame(bundlePath.empty() ? nullptr : &bundle, colorShader, textureShader);
+    std::printf("startup (%s): initialise and fonts %.3f ms, test.rml first frame %.3f ms, total %.3f ms\n\n",
+        bundlePath.empty() ? "loose files" : "bundle", initialiseMs, firstFrameMs, initialiseMs + firstFrameMs);
+
+    const Scene scenes[] = {
+        { "test.rml", std::string(), "data/test.rml", 0 },
+        { "boxes", boxesDocument(elements), nullptr, 0 },
+        { "text", textDocument(elements), nullptr, 0 },
+        { "scroll", scrollDocument(elements), nullptr, std::max(1, elements / 100) },
+    };
+
+    std::printf("%d frames per run, %d elements, renderer %s\n\n", frames, elements, bgfx::getRendererName(bgfx::getRendererType()));
+    std::printf("%-10s %-9s %8s %8s %8s %8s %10s %12s %8s %12s %12s %7s %12s\n",
+        "scene", "path", "mean ms", "p50 ms", "p99 ms", "max ms", "allocs/f", "alloc B/f", "draws/f", "copied B/f", "ref B/f",
+        "dedup", "dedup B");
+
+    for (const Scene & scene : scenes) {
+        if (!only.empty() && only != scene.name)
+            continue;
+
+        const char * paths[] = { "compiled", "dynamic", "decoupled" };
+        for (const char * path : paths) {
+            // A fresh interface per run keeps caches and arenas from leaking between measurements
+            const std::string name = path;
+            RocketBgfxInterface * ui = name == "dynamic"
+                ? new DynamicOnlyInterface(0, colorShader, textureShader, float(WIDTH), float(HEIGHT))
+                : new RocketBgfxInterface(0, colorShader, textureShader, float(WIDTH), float(HEIGHT));
+            ui->setInstancedShaders(colorInstancedShader, textureInstancedShader);
+            ui->setAlphaShader(alphaShader);
+            ui->setDistanceFieldShader(distanceFieldShader);
+            ui->setTextureBudget(textureBudget);
+            ui->setTextureUploadBudget(uploadBudget);
+            if (!bundlePath.empty()) ui->setAssetBundle(&bundle);
+
+            const Result result = name == "decoupled"
+                ? runDecoupledScene(scene, *ui, frames)
+                : runScene(scene, *ui, frames);
+            const RocketBgfxInterface::GeometryCacheStats & geometryCache = ui->getGeometryCacheStats();
+            std::printf("%-10s %-9s %8.3f %8.3f %8.3f %8.3f %10.1f %12.0f %8.1f %12.0f %12.0f %6.1f%% %12llu\n",
+                scene.name, path,
+                result.meanMs, result.p50Ms, result.p99Ms, result.maxMs,
+                result.allocationsPerFrame, result.allocatedBytesPerFrame, result.drawsPerFrame, result.bytesCopiedPerFrame,
+                result.bytesReferencedPerFrame, geometryCache.dedupRatio() * 100.0f, static_cast<unsigned long long>(geometryCache.bytesSaved));
+
+            // libRocket keeps font textures per render interface, drop them before the interface goes
+            Rocket::Core::ReleaseTextures();
+            delete ui;
+        }
+    }
+
+    benchmarkHandleTables();
+    benchmarkTextureLoading(colorShader, textureShader);
+    const bool replayed = checkCaptureReplay(colorShader, textureShader);
+
+    Rocket::Core::Shutdown();
+    if (bgfx::isValid(colorShader)) bgfx::destroyProgram(colorShader);
+    if (bgfx::isValid(textureShader)) bgfx::destroyProgram(textureShader);
+    if (bgfx::isValid(colorInstancedShader)) bgfx::destroyProgram(colorInstancedShader);
+    if (bgfx::isValid(textureInstancedShader)) bgfx::destroyProgram(textureInstancedShader);
+    if (bgfx::isValid(alphaShader)) bgfx::destroyProgram(alphaShader);
+    if (bgfx::isValid(distanceFieldShader)) bgfx::destroyProgram(distanceFieldShader);
+    bgfx::shutdown();
+    return replayed ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+// Offline packer for UI assets: writes documents, stylesheets, fonts and images into one RocketBgfxBundle, which
+// RocketBgfxBundleFileInterface and RocketBgfxInterface::setAssetBundle serve libRocket from without touching the file
+// system again.
+//
+//   BgfxRocketBundleTool --output BUNDLE FILE...
+//
+// Each FILE is stored under the path it is given by, so run the tool from the directory the application loads its
+// documents relative to, e.g. BgfxRocketBundleTool --output ui.bundle data/test.rml assets/rkt.rcss assets/*.otf.
+// Images stb_image reads are decoded here, once, and stored as the RGBA8 texels bgfx is handed at load time; KTX/DDS
+// files from BgfxRocketTextureTool and everything else are stored as they are.
+
+#include "RocketBgfxBundle.hpp"
+#include "RocketBgfxSimd.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <stb_image.h>
+
+namespace {
+    struct Entry {
+        std::string            path;
+        RocketBgfxBundle::Kind kind;
+        uint16_t               width, height;
+        std::vector<uint8_t>   payload;
+    };
+
+    bool isImagePath(const std::string & path) {
+        const size_t dot = path.find_last_of('.');
+        if (dot == std::string::npos)
+            return false;
+        std::string extension = path.substr(dot + 1);
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+        const char * images[] = { "png", "jpg", "jpeg", "tga", "bmp", "psd", "gif", "pic" };
+        return std::find_if(std::begin(images), std::end(images), [&](const char * image) { return extension == image; }) != std::end(images);
+    }
+
+    bool readEntry(const std::string & input, Entry & entry) {
+        entry.path = RocketBgfxBundle::normalizePath(input);
+        entry.width = entry.height = 0;
+        if (isImagePath(input)) {
+            int w = 0, h = 0, channels = 0;
+            unsigned char * pixels = stbi_load(input.c_str(), &w, &h, &channels, STBI_rgb_alpha);
+            if (!pixels || w > UINT16_MAX || h > UINT16_MAX) {
+                const char * reason = pixels ? "IMAGE_TOO_LARGE" : stbi_failure_reason();
+                std::fprintf(stderr, "%s: %s\n", input.c_str(), reason ? reason : "FAILED_TO_LOAD_IMAGE_FROM_FILE");
+                stbi_image_free(pixels);
+                return false;
+            }
+            entry.kind = RocketBgfxBundle::Kind::Image;
+            entry.width = static_cast<uint16_t>(w);
+            entry.height = static_cast<uint16_t>(h);
+            entry.payload.assign(pixels, pixels + size_t(w) * h * 4);
+            stbi_image_free(pixels);
+            return true;
+        }
+
+        std::ifstream in(input, std::ios::binary);
+        if (!in) {
+            std::fprintf(stderr, "%s: can't read\n", input.c_str());
+            return false;
+        }
+        entry.kind = RocketBgfxBundle::Kind::File;
+        entry.payload.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    uint64_t align(uint64_t offset) {
+        return (offset + RocketBgfxBundle::PAYLOAD_ALIGNMENT - 1) / RocketBgfxBundle::PAYLOAD_ALIGNMENT * RocketBgfxBundle::PAYLOAD_ALIGNMENT;
+    }
+
+    bool writeBundle(const std::string & output, const std::vector<Entry> & entries) {
+        std::string paths;
+        for (const Entry & entry : entries) {
+            paths += entry.path;
+        }
+
+        RocketBgfxBundle::Header header = { RocketBgfxBundle::MAGIC, RocketBgfxBundle::VERSION, uint32_t(entries.size()), uint32_t(paths.size()) };
+        std::vector<RocketBgfxBundle::Record> records;
+        uint64_t offset = align(sizeof(header) + entries.size() * sizeof(RocketBgfxBundle::Record) + paths.size());
+        uint32_t pathOffset = 0;
+        for (const Entry & entry : entries) {
+            RocketBgfxBundle::Record record;
+            std::memset(&record, 0, sizeof(record));
+            record.offset = offset;
+            record.size = entry.payload.size();
+            record.contentHash = RocketBgfxSimd::hash(entry.payload.data(), entry.payload.size());
+            record.pathOffset = pathOffset;
+            record.pathLength = uint32_t(entry.path.size());
+            record.kind = entry.kind;
+            record.width = entry.width;
+            record.height = entry.height;
+            records.push_back(record);
+            pathOffset += record.pathLength;
+            offset = align(offset + record.size);
+        }
+
+        std::ofstream out(output, std::ios::binary);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(RocketBgfxBundle::Record)));
+        out.write(paths.data(), static_cast<std::streamsize>(paths.size()));
+        const char padding[RocketBgfxBundle::PAYLOAD_ALIGNMENT] = {};
+        uint64_t written = sizeof(header) + records.size() * sizeof(RocketBgfxBundle::Record) + paths.size();
+        for (size_t i = 0; i < entries.size(); ++i) {
+            out.write(padding, static_cast<std::streamsize>(records[i].offset - written));
+            out.write(reinterpret_cast<const char *>(entries[i].payload.data()), static_cast<std::streamsize>(entries[i].payload.size()));
+            written = records[i].offset + records[i].size;
+        }
+        if (!out) {
+            std::fprintf(stderr, "%s: can't write\n", output.c_str());
+            return false;
+        }
+        std::printf("%s: %zu assets, %llu bytes\n", output.c_str(), entries.size(), static_cast<unsigned long long>(written));
+        return true;
+    }
+}
+
+int main(int argc, char ** argv) {
+    std::string output;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--output" && i + 1 < argc) output = argv[++i];
+        else inputs.push_back(arg);
+    }
+    if (output.empty() || inputs.empty()) {
+        std::fprintf(stderr, "usage: BgfxRocketBundleTool --output BUNDLE FILE...\n");
+        return 1;
+    }
+
+    std::vector<Entry> entries;
+    int failures = 0;
+    for (const std::string & input : inputs) {
+        Entry entry;
+        if (!readEntry(input, entry)) {
+            failures++;
+            continue;
+        }
+        std::printf("%s: %s, %zu bytes\n", entry.path.c_str(), entry.kind == RocketBgfxBundle::Kind::Image ? "RGBA8" : "file", entry.payload.size());
+        entries.push_back(std::move(entry));
+    }
+    if (failures)
+        return 1;
+    return writeBundle(output, entries) ? 0 : 1;
+}
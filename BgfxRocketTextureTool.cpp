@@ -0,0 +1,292 @@
+// Offline converter for UI images: decodes them with stb_image, builds a mip chain and writes a DDS or KTX container
+// that RocketBgfxInterface::LoadTexture maps and uploads without decoding.
+//
+//   BgfxRocketTextureTool [--ktx] [--rgba8] [--no-mips] IMAGE...
+//
+// Each IMAGE is written next to itself with a .dds (or .ktx) extension; point the RCSS at that file instead. Texels are
+// BC3 (DXT5) by default, which every desktop GPU samples natively at a quarter of RGBA8's size; --rgba8 keeps them
+// uncompressed, for art that must stay exact. Mips are box filtered with alpha weighting, so transparent texels don't
+// bleed their color into the edges of shapes.
+
+#include "RocketBgfxTextureContainer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <stb_image.h>
+
+namespace {
+    struct Image {
+        uint32_t             width, height;
+        std::vector<uint8_t> rgba;
+    };
+
+    // Half the size, each texel the alpha weighted average of the up to four it covers
+    Image downsample(const Image & source) {
+        Image mip;
+        mip.width = std::max(source.width / 2, 1u);
+        mip.height = std::max(source.height / 2, 1u);
+        mip.rgba.resize(size_t(mip.width) * mip.height * 4);
+        for (uint32_t y = 0; y < mip.height; ++y) {
+            for (uint32_t x = 0; x < mip.width; ++x) {
+                uint32_t color[3] = { 0, 0, 0 };
+                uint32_t alpha = 0;
+                for (uint32_t sample = 0; sample < 4; ++sample) {
+                    const uint32_t sx = std::min(x * 2 + (sample & 1), source.width - 1);
+                    const uint32_t sy = std::min(y * 2 + (sample >> 1), source.height - 1);
+                    const uint8_t * texel = &source.rgba[(size_t(sy) * source.width + sx) * 4];
+                    for (int channel = 0; channel < 3; ++channel) {
+                        color[channel] += texel[channel] * texel[3];
+                    }
+                    alpha += texel[3];
+                }
+                uint8_t * out = &mip.rgba[(size_t(y) * mip.width + x) * 4];
+                for (int channel = 0; channel < 3; ++channel) {
+                    out[channel] = static_cast<uint8_t>(alpha ? (color[channel] + alpha / 2) / alpha : 0);
+                }
+                out[3] = static_cast<uint8_t>((alpha + 2) / 4);
+            }
+        }
+        return mip;
+    }
+
+    inline uint16_t to565(const uint8_t * rgb) noexcept {
+        return static_cast<uint16_t>(((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3));
+    }
+    inline void from565(uint16_t color, int * rgb) noexcept {
+        rgb[0] = ((color >> 11) & 31) * 255 / 31;
+        rgb[1] = ((color >> 5) & 63) * 255 / 63;
+        rgb[2] = (color & 31) * 255 / 31;
+    }
+
+    // One 4x4 block of BC3: interpolated 8-bit alpha, then a BC1 color block. Endpoints are the bounding box of the
+    // block's visible colors, inset by a sixteenth of its extent (J.M.P. van Waveren, "Real-Time DXT Compression").
+    void encodeBc3Block(const uint8_t * texels, uint8_t * out) {
+        uint8_t alphaMax = 0, alphaMin = 255;
+        uint8_t colorMax[3] = { 0, 0, 0 }, colorMin[3] = { 255, 255, 255 };
+        bool visible = false;
+        for (int t = 0; t < 16; ++t) {
+            const uint8_t * texel = texels + t * 4;
+            alphaMax = std::max(alphaMax, texel[3]);
+            alphaMin = std::min(alphaMin, texel[3]);
+            if (texel[3] == 0)
+                continue;
+            visible = true;
+            for (int channel = 0; channel < 3; ++channel) {
+                colorMax[channel] = std::max(colorMax[channel], texel[channel]);
+                colorMin[channel] = std::min(colorMin[channel], texel[channel]);
+            }
+        }
+        if (!visible) {
+            std::memset(colorMax, 0, sizeof(colorMax));
+            std::memset(colorMin, 0, sizeof(colorMin));
+        }
+        for (int channel = 0; channel < 3; ++channel) {
+            const int inset = (colorMax[channel] - colorMin[channel]) >> 4;
+            colorMax[channel] = static_cast<uint8_t>(colorMax[channel] - inset);
+            colorMin[channel] = static_cast<uint8_t>(colorMin[channel] + inset);
+        }
+
+        // Alpha: a0 > a1 selects the eight value palette
+        int alphaPalette[8] = { alphaMax, alphaMin };
+        for (int i = 2; i < 8; ++i) {
+            alphaPalette[i] = ((8 - i) * alphaMax + (i - 1) * alphaMin) / 7;
+        }
+        uint64_t alphaBits = 0;
+        for (int t = 0; t < 16; ++t) {
+            int best = 0;
+            for (int i = 1; i < 8 && alphaMax != alphaMin; ++i) {
+                if (std::abs(alphaPalette[i] - texels[t * 4 + 3]) < std::abs(alphaPalette[best] - texels[t * 4 + 3])) {
+                    best = i;
+                }
+            }
+            alphaBits |= uint64_t(best) << (3 * t);
+        }
+        out[0] = alphaMax;
+        out[1] = alphaMin;
+        for (int i = 0; i < 6; ++i) {
+            out[2 + i] = static_cast<uint8_t>(alphaBits >> (8 * i));
+        }
+
+        // Color: BC3 always decodes the four color palette
+        uint16_t endpoints[2] = { to565(colorMax), to565(colorMin) };
+        if (endpoints[0] < endpoints[1]) {
+            std::swap(endpoints[0], endpoints[1]);
+        }
+        int palette[4][3];
+        from565(endpoints[0], palette[0]);
+        from565(endpoints[1], palette[1]);
+        for (int channel = 0; channel < 3; ++channel) {
+            palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+            palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+        }
+        uint32_t colorBits = 0;
+        for (int t = 0; t < 16; ++t) {
+            int best = 0, bestError = INT32_MAX;
+            for (int i = 0; i < 4 && endpoints[0] != endpoints[1]; ++i) {
+                int error = 0;
+                for (int channel = 0; channel < 3; ++channel) {
+                    const int delta = palette[i][channel] - texels[t * 4 + channel];
+                    error += delta * delta;
+                }
+                if (error < bestError) {
+                    best = i;
+                    bestError = error;
+                }
+            }
+            colorBits |= uint32_t(best) << (2 * t);
+        }
+        out[8] = static_cast<uint8_t>(endpoints[0]);
+        out[9] = static_cast<uint8_t>(endpoints[0] >> 8);
+        out[10] = static_cast<uint8_t>(endpoints[1]);
+        out[11] = static_cast<uint8_t>(endpoints[1] >> 8);
+        for (int i = 0; i < 4; ++i) {
+            out[12 + i] = static_cast<uint8_t>(colorBits >> (8 * i));
+        }
+    }
+    std::vector<uint8_t> encodeBc3(const Image & image) {
+        const uint32_t blocksX = (image.width + 3) / 4, blocksY = (image.height + 3) / 4;
+        std::vector<uint8_t> blocks(size_t(blocksX) * blocksY * 16);
+        uint8_t texels[64];
+        for (uint32_t by = 0; by < blocksY; ++by) {
+            for (uint32_t bx = 0; bx < blocksX; ++bx) {
+                // Blocks hanging over the edge repeat the last row and column
+                for (uint32_t t = 0; t < 16; ++t) {
+                    const uint32_t x = std::min(bx * 4 + (t & 3), image.width - 1);
+                    const uint32_t y = std::min(by * 4 + (t >> 2), image.height - 1);
+                    std::memcpy(texels + t * 4, &image.rgba[(size_t(y) * image.width + x) * 4], 4);
+                }
+                encodeBc3Block(texels, &blocks[(size_t(by) * blocksX + bx) * 16]);
+            }
+        }
+        return blocks;
+    }
+
+    void put32(std::vector<uint8_t> & out, uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+    std::vector<uint8_t> ddsHeader(const Image & image, uint32_t mips, bool compressed, uint32_t topLevelBytes) {
+        std::vector<uint8_t> header;
+        header.insert(header.end(), { 'D', 'D', 'S', ' ' });
+        put32(header, 124);
+        put32(header, 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | (compressed ? 0x80000 : 0x8));   // caps, size, pixel format, mips, linear size or pitch
+        put32(header, image.height);
+        put32(header, image.width);
+        put32(header, compressed ? topLevelBytes : image.width * 4);
+        put32(header, 0);
+        put32(header, mips);
+        for (int i = 0; i < 11; ++i) {
+            put32(header, 0);
+        }
+        // DDS_PIXELFORMAT
+        put32(header, 32);
+        put32(header, compressed ? 0x4 : 0x41);                 // fourCC, or RGB with alpha
+        header.insert(header.end(), { uint8_t(compressed ? 'D' : 0), uint8_t(compressed ? 'X' : 0), uint8_t(compressed ? 'T' : 0), uint8_t(compressed ? '5' : 0) });
+        put32(header, compressed ? 0 : 32);
+        put32(header, compressed ? 0 : 0x000000FF);
+        put32(header, compressed ? 0 : 0x0000FF00);
+        put32(header, compressed ? 0 : 0x00FF0000);
+        put32(header, compressed ? 0 : 0xFF000000);
+        put32(header, 0x1000 | (mips > 1 ? 0x8 | 0x400000 : 0));  // texture, complex and mipmap
+        for (int i = 0; i < 4; ++i) {
+            put32(header, 0);
+        }
+        return header;
+    }
+    std::vector<uint8_t> ktxHeader(const Image & image, uint32_t mips, bool compressed) {
+        std::vector<uint8_t> header = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+        put32(header, 0x04030201);
+        put32(header, compressed ? 0 : 0x1401);         // glType: GL_UNSIGNED_BYTE
+        put32(header, 1);
+        put32(header, compressed ? 0 : 0x1908);         // glFormat: GL_RGBA
+        put32(header, compressed ? 0x83F3 : 0x8058);    // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT or GL_RGBA8
+        put32(header, 0x1908);
+        put32(header, image.width);
+        put32(header, image.height);
+        put32(header, 0);
+        put32(header, 0);
+        put32(header, 1);
+        put32(header, mips);
+        put32(header, 0);
+        return header;
+    }
+
+    std::string outputPath(const std::string & input, bool ktx) {
+        const size_t slash = input.find_last_of("/\\");
+        const size_t dot = input.find_last_of('.');
+        const std::string stem = dot != std::string::npos && (slash == std::string::npos || dot > slash) ? input.substr(0, dot) : input;
+        return stem + (ktx ? ".ktx" : ".dds");
+    }
+
+    bool convert(const std::string & input, bool ktx, bool compressed, bool mipmaps) {
+        int w = 0, h = 0, channels = 0;
+        unsigned char * pixels = stbi_load(input.c_str(), &w, &h, &channels, STBI_rgb_alpha);
+        if (!pixels) {
+            const char * reason = stbi_failure_reason();
+            std::fprintf(stderr, "%s: %s\n", input.c_str(), reason ? reason : "FAILED_TO_LOAD_IMAGE_FROM_FILE");
+            return false;
+        }
+        Image level = { uint32_t(w), uint32_t(h), std::vector<uint8_t>(pixels, pixels + size_t(w) * h * 4) };
+        stbi_image_free(pixels);
+
+        const uint32_t mips = mipmaps ? RocketBgfxTextureContainer::fullMipCount(level.width, level.height) : 1;
+        const bgfx::TextureFormat::Enum format = compressed ? bgfx::TextureFormat::BC3 : bgfx::TextureFormat::RGBA8;
+        const uint32_t topLevelBytes = RocketBgfxTextureContainer::storageSize(format, level.width, level.height, 1);
+        std::vector<uint8_t> file = ktx ? ktxHeader(level, mips, compressed) : ddsHeader(level, mips, compressed, topLevelBytes);
+
+        for (uint32_t mip = 0; mip < mips; ++mip) {
+            if (mip > 0) {
+                level = downsample(level);
+            }
+            const std::vector<uint8_t> texels = compressed ? encodeBc3(level) : level.rgba;
+            if (ktx) {
+                put32(file, static_cast<uint32_t>(texels.size()));
+            }
+            file.insert(file.end(), texels.begin(), texels.end());
+            // Every level of a KTX file starts 4 byte aligned; BC3 and RGBA8 levels always are
+        }
+
+        const std::string output = outputPath(input, ktx);
+        std::ofstream out(output, std::ios::binary);
+        out.write(reinterpret_cast<const char *>(file.data()), static_cast<std::streamsize>(file.size()));
+        if (!out) {
+            std::fprintf(stderr, "%s: can't write\n", output.c_str());
+            return false;
+        }
+        std::printf("%s -> %s: %dx%d, %u mips, %zu bytes (RGBA8 %u)\n", input.c_str(), output.c_str(), w, h, mips, file.size(),
+            RocketBgfxTextureContainer::storageSize(bgfx::TextureFormat::RGBA8, uint32_t(w), uint32_t(h), mips));
+        return true;
+    }
+}
+
+int main(int argc, char ** argv) {
+    bool ktx = false, compressed = true, mipmaps = true;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--ktx") ktx = true;
+        else if (arg == "--rgba8") compressed = false;
+        else if (arg == "--no-mips") mipmaps = false;
+        else inputs.push_back(arg);
+    }
+    if (inputs.empty()) {
+        std::fprintf(stderr, "usage: BgfxRocketTextureTool [--ktx] [--rgba8] [--no-mips] IMAGE...\n");
+        return 1;
+    }
+
+    int failures = 0;
+    for (const std::string & input : inputs) {
+        if (!convert(input, ktx, compressed, mipmaps)) {
+            failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+#include "RocketBgfxBundle.hpp"
+
+#include <cstring>
+#include <vector>
+
+static_assert(sizeof(RocketBgfxBundle::Header) == 16, "bundle header layout");
+static_assert(sizeof(RocketBgfxBundle::Record) == 40, "bundle record layout");
+
+// Every record is checked against the mapping here, so find() can hand out assets without looking at them again
+bool RocketBgfxBundle::open(const std::string & path, std::string & error) {
+    close();
+    if (!_file.open(path)) {
+        error = "FAILED_TO_MAP_FILE";
+        return false;
+    }
+
+    Header header;
+    if (_file.size() < sizeof(header)) {
+        error = "BUNDLE_TRUNCATED";
+        close();
+        return false;
+    }
+    std::memcpy(&header, _file.data(), sizeof(header));
+    if (header.magic != MAGIC) {
+        error = "NOT_A_BUNDLE";
+        close();
+        return false;
+    }
+    if (header.version != VERSION) {
+        error = "BUNDLE_VERSION_NOT_SUPPORTED";
+        close();
+        return false;
+    }
+    const uint64_t pathTable = sizeof(Header) + uint64_t(header.entries) * sizeof(Record);
+    if (pathTable + header.pathBytes > _file.size()) {
+        error = "BUNDLE_TRUNCATED";
+        close();
+        return false;
+    }
+
+    const char * paths = reinterpret_cast<const char *>(_file.data() + pathTable);
+    _assets.reserve(header.entries);
+    for (uint32_t i = 0; i < header.entries; ++i) {
+        Record record;
+        std::memcpy(&record, _file.data() + sizeof(Header) + size_t(i) * sizeof(Record), sizeof(record));
+        const bool valid = uint64_t(record.pathOffset) + record.pathLength <= header.pathBytes
+            && record.offset % PAYLOAD_ALIGNMENT == 0
+            && record.offset <= _file.size() && record.size <= _file.size() - record.offset
+            && (record.kind == Kind::File
+                || (record.kind == Kind::Image && record.size == uint64_t(record.width) * record.height * 4 && record.size));
+        if (!valid) {
+            error = "BUNDLE_CORRUPT";
+            close();
+            return false;
+        }
+        const Asset asset = { _file.data() + record.offset, size_t(record.size), record.kind, record.width, record.height, record.contentHash };
+        _assets[std::string(paths + record.pathOffset, record.pathLength)] = asset;
+    }
+    return true;
+}
+void RocketBgfxBundle::close() {
+    _assets.clear();
+    _file.close();
+}
+const RocketBgfxBundle::Asset * RocketBgfxBundle::find(const std::string & path) const {
+    auto asset = _assets.find(normalizePath(path));
+    return asset != _assets.end() ? &asset->second : nullptr;
+}
+// libRocket joins a document's directory and its relative URLs, so the same file turns up as "data/../assets/x" and
+// "assets/x". Folding the path makes both find what the bundler stored from its command line.
+std::string RocketBgfxBundle::normalizePath(const std::string & path) {
+    std::vector<std::string> segments;
+    std::string segment;
+    const bool absolute = !path.empty() && (path[0] == '/' || path[0] == '\\');
+    for (size_t i = 0; i <= path.size(); ++i) {
+        if (i < path.size() && path[i] != '/' && path[i] != '\\') {
+            segment += path[i];
+            continue;
+        }
+        if (segment == "..") {
+            if (!segments.empty() && segments.back() != "..") {
+                segments.pop_back();
+            }
+            else if (!absolute) {
+                segments.push_back(segment);
+            }
+        }
+        else if (!segment.empty() && segment != ".") {
+            segments.push_back(segment);
+        }
+        segment.clear();
+    }
+
+    std::string normalized = absolute ? "/" : "";
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (i > 0) normalized += '/';
+        normalized += segments[i];
+    }
+    return normalized;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "RocketBgfxMappedFile.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// A pack of UI assets written by BgfxRocketBundleTool, so a document, its stylesheets, fonts and images open from one
+// mapped file instead of a file system walk and an image decode each.
+//
+// The file is a "BNDL" header, one Record per asset, the paths they are found by, then the payloads, each aligned to
+// 16 bytes. Images are stored decoded, as the RGBA8 texels bgfx is handed directly; KTX/DDS files and everything else
+// are stored as they are. Everything is in the writer's byte order.
+class RocketBgfxBundle
+{
+public:
+    constexpr static const uint32_t MAGIC = 0x4c444e42;    // "BNDL"
+    constexpr static const uint32_t VERSION = 1;
+    constexpr static const uint32_t PAYLOAD_ALIGNMENT = 16;
+
+    enum class Kind : uint32_t {
+        File = 0,                   // the file's bytes
+        Image,                      // width x height RGBA8 texels
+    };
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entries;
+        uint32_t pathBytes;         // of the path table after the records
+    };
+    struct Record {
+        uint64_t offset;            // of the payload from the start of the file
+        uint64_t size;
+        uint64_t contentHash;       // RocketBgfxSimd::hash of the payload
+        uint32_t pathOffset;        // into the path table, paths are not terminated
+        uint32_t pathLength;
+        Kind     kind;
+        uint16_t width, height;     // Image only
+    };
+
+    // An asset inside the mapping, valid while the bundle is open
+    struct Asset {
+        const uint8_t * data;
+        size_t          size;
+        Kind            kind;
+        uint16_t        width, height;
+        uint64_t        contentHash;
+    };
+
+    RocketBgfxBundle() = default;
+
+    /// Map a bundle and index it. On failure error says why, in LoadTexture's failure reason style.
+    bool open(const std::string & path, std::string & error);
+    void close();
+    bool isOpen() const noexcept { return _file.isOpen(); }
+
+    /// The asset stored under a path, after normalizePath(); nullptr when the bundle doesn't have it
+    const Asset * find(const std::string & path) const;
+    size_t size() const noexcept { return _assets.size(); }
+    size_t bytes() const noexcept { return _file.size(); }
+
+    /// The key an asset is stored and found by: forward slashes, no "." segments and ".." folded into their parent
+    static std::string normalizePath(const std::string & path);
+
+private:
+    RocketBgfxBundle(const RocketBgfxBundle&) = delete; // non construction-copyable
+    RocketBgfxBundle& operator=(const RocketBgfxBundle&) = delete; // non copyable
+
+    RocketBgfxMappedFile                   _file;
+    std::unordered_map<std::string, Asset> _assets;
+};
@@ -0,0 +1,46 @@
+#include "RocketBgfxBundleFileInterface.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+Rocket::Core::FileHandle RocketBgfxBundleFileInterface::Open(const Rocket::Core::String& path) {
+    const RocketBgfxBundle::Asset * asset = _bundle.find(path.CString());
+    if (asset && asset->kind == RocketBgfxBundle::Kind::File)
+        return reinterpret_cast<Rocket::Core::FileHandle>(new Stream{ asset->data, asset->size, 0, nullptr });
+
+    FILE * file = std::fopen(path.CString(), "rb");
+    if (!file)
+        return 0;
+    return reinterpret_cast<Rocket::Core::FileHandle>(new Stream{ nullptr, 0, 0, file });
+}
+void RocketBgfxBundleFileInterface::Close(Rocket::Core::FileHandle file) {
+    Stream * stream = reinterpret_cast<Stream *>(file);
+    if (stream->file) std::fclose(stream->file);
+    delete stream;
+}
+size_t RocketBgfxBundleFileInterface::Read(void* buffer, size_t size, Rocket::Core::FileHandle file) {
+    Stream * stream = reinterpret_cast<Stream *>(file);
+    if (stream->file)
+        return std::fread(buffer, 1, size, stream->file);
+
+    const size_t read = std::min(size, stream->size - stream->position);
+    std::memcpy(buffer, stream->data + stream->position, read);
+    stream->position += read;
+    return read;
+}
+// Like fseek a bundled file can't be positioned before its start, but unlike it not past its end either
+bool RocketBgfxBundleFileInterface::Seek(Rocket::Core::FileHandle file, long offset, int origin) {
+    Stream * stream = reinterpret_cast<Stream *>(file);
+    if (stream->file)
+        return std::fseek(stream->file, offset, origin) == 0;
+
+    const long base = origin == SEEK_SET ? 0 : origin == SEEK_CUR ? long(stream->position) : long(stream->size);
+    if (base + offset < 0 || size_t(base + offset) > stream->size)
+        return false;
+    stream->position = size_t(base + offset);
+    return true;
+}
+size_t RocketBgfxBundleFileInterface::Tell(Rocket::Core::FileHandle file) {
+    Stream * stream = reinterpret_cast<Stream *>(file);
+    return stream->file ? size_t(std::ftell(stream->file)) : stream->position;
+}
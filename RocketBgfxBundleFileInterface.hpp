@@ -0,0 +1,38 @@
+#pragma once
+
+#include "RocketBgfxBundle.hpp"
+
+#include <Rocket/Core/FileInterface.h>
+
+#include <cstdio>
+
+// Serves libRocket's documents, stylesheets and fonts out of a bundle: every read is a copy straight out of the mapping,
+// with no open or read call reaching the file system. Paths the bundle doesn't have are opened from disk as libRocket's
+// default file interface would. Install it with Rocket::Core::SetFileInterface() before Rocket::Core::Initialise();
+// the bundle must outlive it.
+class RocketBgfxBundleFileInterface :
+    public Rocket::Core::FileInterface
+{
+public:
+    explicit RocketBgfxBundleFileInterface(const RocketBgfxBundle & bundle) noexcept : _bundle(bundle) {}
+
+    virtual Rocket::Core::FileHandle Open(const Rocket::Core::String& path) override;
+    virtual void Close(Rocket::Core::FileHandle file) override;
+    virtual size_t Read(void* buffer, size_t size, Rocket::Core::FileHandle file) override;
+    virtual bool Seek(Rocket::Core::FileHandle file, long offset, int origin) override;
+    virtual size_t Tell(Rocket::Core::FileHandle file) override;
+
+private:
+    RocketBgfxBundleFileInterface(const RocketBgfxBundleFileInterface&) = delete; // non construction-copyable
+    RocketBgfxBundleFileInterface& operator=(const RocketBgfxBundleFileInterface&) = delete; // non copyable
+
+    // An open file: a window on the mapping, or a file on disk when the bundle doesn't have it
+    struct Stream {
+        const uint8_t * data;
+        size_t          size;
+        size_t          position;
+        FILE *          file;
+    };
+
+    const RocketBgfxBundle & _bundle;
+};
@@ -0,0 +1,288 @@
+#include "RocketBgfxCapture.hpp"
+
+#include <cstring>
+#include <vector>
+
+namespace {
+    size_t padded(size_t size) noexcept { return (size + 3) & ~size_t(3); }
+
+    template <typename T> T read(const uint8_t * payload, size_t offset) noexcept {
+        T value;
+        std::memcpy(&value, payload + offset, sizeof(T));
+        return value;
+    }
+}
+
+RocketBgfxCaptureWriter::RocketBgfxCaptureWriter(const std::string & path)
+    : _file(path, std::ios::binary | std::ios::out | std::ios::trunc), _bytesWritten(0)
+{
+    if (_file.is_open()) {
+        write(uint32_t(RocketBgfxCapture::MAGIC));
+        write(uint32_t(RocketBgfxCapture::VERSION));
+    }
+}
+RocketBgfxCaptureWriter::~RocketBgfxCaptureWriter() {
+    _file.flush();
+}
+void RocketBgfxCaptureWriter::begin(RocketBgfxCapture::Record type, size_t payload) {
+    write(static_cast<uint32_t>(type));
+    write(static_cast<uint32_t>(padded(payload)));
+}
+void RocketBgfxCaptureWriter::write(const void * data, size_t size) {
+    _file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+    _bytesWritten += size;
+}
+void RocketBgfxCaptureWriter::pad(size_t size) {
+    const uint8_t zeros[4] = { 0, 0, 0, 0 };
+    write(zeros, padded(size) - size);
+}
+void RocketBgfxCaptureWriter::renderGeometry(const Rocket::Core::Vertex * vertices, int num_vertices, const int * indices, int num_indices,
+    Rocket::Core::TextureHandle texture, const Rocket::Core::Vector2f & translation)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    const size_t vertexBytes = size_t(num_vertices) * sizeof(Rocket::Core::Vertex);
+    const size_t indexBytes = size_t(num_indices) * sizeof(int32_t);
+    begin(RocketBgfxCapture::Record::RenderGeometry, 24 + vertexBytes + indexBytes);
+    write(static_cast<uint32_t>(num_vertices));
+    write(static_cast<uint32_t>(num_indices));
+    write(static_cast<uint64_t>(texture));
+    write(translation.x);
+    write(translation.y);
+    write(vertices, vertexBytes);
+    write(indices, indexBytes);
+}
+void RocketBgfxCaptureWriter::compileGeometry(Rocket::Core::CompiledGeometryHandle geometry, const Rocket::Core::Vertex * vertices, int num_vertices,
+    const int * indices, int num_indices, Rocket::Core::TextureHandle texture)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    const size_t vertexBytes = size_t(num_vertices) * sizeof(Rocket::Core::Vertex);
+    const size_t indexBytes = size_t(num_indices) * sizeof(int32_t);
+    begin(RocketBgfxCapture::Record::CompileGeometry, 24 + vertexBytes + indexBytes);
+    write(static_cast<uint64_t>(geometry));
+    write(static_cast<uint32_t>(num_vertices));
+    write(static_cast<uint32_t>(num_indices));
+    write(static_cast<uint64_t>(texture));
+    write(vertices, vertexBytes);
+    write(indices, indexBytes);
+}
+void RocketBgfxCaptureWriter::renderCompiledGeometry(Rocket::Core::CompiledGeometryHandle geometry, const Rocket::Core::Vector2f & translation) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    begin(RocketBgfxCapture::Record::RenderCompiledGeometry, 16);
+    write(static_cast<uint64_t>(geometry));
+    write(translation.x);
+    write(translation.y);
+}
+void RocketBgfxCaptureWriter::releaseCompiledGeometry(Rocket::Core::CompiledGeometryHandle geometry) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    begin(RocketBgfxCapture::Record::ReleaseCompiledGeometry, 8);
+    write(static_cast<uint64_t>(geometry));
+}
+void RocketBgfxCaptureWriter::enableScissorRegion(bool enable) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    begin(RocketBgfxCapture::Record::EnableScissorRegion, 4);
+    write(static_cast<uint32_t>(enable));
+}
+void RocketBgfxCaptureWriter::setScissorRegion(int x, int y, int width, int height) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    begin(RocketBgfxCapture::Record::SetScissorRegion, 16);
+    write(static_cast<int32_t>(x));
+    write(static_cast<int32_t>(y));
+    write(static_cast<int32_t>(width));
+    write(static_cast<int32_t>(height));
+}
+// Only the path and size are kept, the replay loads the file again if it can and substitutes a blank image otherwise
+void RocketBgfxCaptureWriter::loadTexture(Rocket::Core::TextureHandle texture, const Rocket::Core::Vector2i & dimensions, const Rocket::Core::String & source) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const size_t length = std::strlen(source.CString());
+    begin(RocketBgfxCapture::Record::LoadTexture, 20 + length);
+    write(static_cast<uint64_t>(texture));
+    write(static_cast<int32_t>(dimensions.x));
+    write(static_cast<int32_t>(dimensions.y));
+    write(static_cast<uint32_t>(length));
+    write(source.CString(), length);
+    pad(length);
+}
+void RocketBgfxCaptureWriter::generateTexture(Rocket::Core::TextureHandle texture, const Rocket::Core::byte * source, const Rocket::Core::Vector2i & dimensions) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const size_t bytes = size_t(dimensions.x) * dimensions.y * sizeof(uint32_t);
+    begin(RocketBgfxCapture::Record::GenerateTexture, 16 + bytes);
+    write(static_cast<uint64_t>(texture));
+    write(static_cast<int32_t>(dimensions.x));
+    write(static_cast<int32_t>(dimensions.y));
+    write(source, bytes);
+}
+void RocketBgfxCaptureWriter::releaseTexture(Rocket::Core::TextureHandle texture) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    begin(RocketBgfxCapture::Record::ReleaseTexture, 8);
+    write(static_cast<uint64_t>(texture));
+}
+void RocketBgfxCaptureWriter::frame() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    begin(RocketBgfxCapture::Record::Frame, 0);
+}
+
+RocketBgfxCaptureReplayer::RocketBgfxCaptureReplayer(const std::string & path)
+    : _file(path), _valid(false), _cursor(8), _frames(0)
+{
+    _valid = _file.isOpen() && _file.size() >= 8
+        && read<uint32_t>(_file.data(), 0) == RocketBgfxCapture::MAGIC
+        && read<uint32_t>(_file.data(), 4) == RocketBgfxCapture::VERSION;
+}
+// Anything still alive belongs to whichever interface it was replayed into; rewind() gives it back
+RocketBgfxCaptureReplayer::~RocketBgfxCaptureReplayer() {
+}
+bool RocketBgfxCaptureReplayer::replayFrame(Rocket::Core::RenderInterface & target) {
+    if (!_valid)
+        return false;
+
+    bool replayed = false;
+    while (_cursor + 8 <= _file.size()) {
+        const RocketBgfxCapture::Record type = static_cast<RocketBgfxCapture::Record>(read<uint32_t>(_file.data(), _cursor));
+        const uint32_t size = read<uint32_t>(_file.data(), _cursor + 4);
+        if (_cursor + 8 + size > _file.size()) {
+            // Truncated, e.g. the recording process died
+            _cursor = _file.size();
+            break;
+        }
+
+        replay(type, _file.data() + _cursor + 8, size, target);
+        _cursor += 8 + size;
+        replayed = true;
+
+        if (type == RocketBgfxCapture::Record::Frame) {
+            _frames++;
+            return true;
+        }
+    }
+    return replayed;
+}
+void RocketBgfxCaptureReplayer::rewind(Rocket::Core::RenderInterface & target) {
+    for (const auto & geometry : _geometry) {
+        for (uint32_t reference = 0; reference < geometry.second.references; ++reference) {
+            target.ReleaseCompiledGeometry(geometry.second.handle);
+        }
+    }
+    for (const auto & texture : _textures) {
+        for (uint32_t reference = 0; reference < texture.second.references; ++reference) {
+            target.ReleaseTexture(texture.second.handle);
+        }
+    }
+    _geometry.clear();
+    _textures.clear();
+    _cursor = 8;
+    _frames = 0;
+}
+uintptr_t RocketBgfxCaptureReplayer::texture(uint64_t recorded) const {
+    auto mapped = _textures.find(recorded);
+    return mapped != _textures.end() ? mapped->second.handle : 0;
+}
+void RocketBgfxCaptureReplayer::addReference(std::unordered_map<uint64_t, Mapped> & mapping, uint64_t recorded, uintptr_t handle) {
+    Mapped & mapped = mapping[recorded];
+    mapped.handle = handle;
+    mapped.references++;
+}
+// Payload sizes were checked against the file, records too short for their own counts are skipped
+void RocketBgfxCaptureReplayer::replay(RocketBgfxCapture::Record type, const uint8_t * payload, uint32_t size, Rocket::Core::RenderInterface & target) {
+    typedef RocketBgfxCapture::Record Record;
+
+    switch (type) {
+    case Record::RenderGeometry: {
+        if (size < 24) return;
+        const uint32_t numVertices = read<uint32_t>(payload, 0);
+        const uint32_t numIndices = read<uint32_t>(payload, 4);
+        if (24 + size_t(numVertices) * sizeof(Rocket::Core::Vertex) + size_t(numIndices) * sizeof(int32_t) > size) return;
+
+        // The mapping is read-only, but the interface never writes through these pointers
+        auto * vertices = reinterpret_cast<Rocket::Core::Vertex *>(const_cast<uint8_t *>(payload + 24));
+        auto * indices = reinterpret_cast<int *>(const_cast<uint8_t *>(payload + 24 + numVertices * sizeof(Rocket::Core::Vertex)));
+        target.RenderGeometry(vertices, int(numVertices), indices, int(numIndices), texture(read<uint64_t>(payload, 8)),
+            Rocket::Core::Vector2f(read<float>(payload, 16), read<float>(payload, 20)));
+        break;
+    }
+    case Record::CompileGeometry: {
+        if (size < 24) return;
+        const uint32_t numVertices = read<uint32_t>(payload, 8);
+        const uint32_t numIndices = read<uint32_t>(payload, 12);
+        if (24 + size_t(numVertices) * sizeof(Rocket::Core::Vertex) + size_t(numIndices) * sizeof(int32_t) > size) return;
+
+        auto * vertices = reinterpret_cast<Rocket::Core::Vertex *>(const_cast<uint8_t *>(payload + 24));
+        auto * indices = reinterpret_cast<int *>(const_cast<uint8_t *>(payload + 24 + numVertices * sizeof(Rocket::Core::Vertex)));
+        const Rocket::Core::CompiledGeometryHandle geometry = target.CompileGeometry(vertices, int(numVertices), indices, int(numIndices),
+            texture(read<uint64_t>(payload, 16)));
+        if (geometry) {
+            addReference(_geometry, read<uint64_t>(payload, 0), geometry);
+        }
+        break;
+    }
+    case Record::RenderCompiledGeometry: {
+        if (size < 16) return;
+        auto geometry = _geometry.find(read<uint64_t>(payload, 0));
+        if (geometry != _geometry.end()) {
+            target.RenderCompiledGeometry(geometry->second.handle, Rocket::Core::Vector2f(read<float>(payload, 8), read<float>(payload, 12)));
+        }
+        break;
+    }
+    case Record::ReleaseCompiledGeometry: {
+        if (size < 8) return;
+        auto geometry = _geometry.find(read<uint64_t>(payload, 0));
+        if (geometry != _geometry.end()) {
+            target.ReleaseCompiledGeometry(geometry->second.handle);
+            if (--geometry->second.references == 0) {
+                _geometry.erase(geometry);
+            }
+        }
+        break;
+    }
+    case Record::EnableScissorRegion:
+        if (size < 4) return;
+        target.EnableScissorRegion(read<uint32_t>(payload, 0) != 0);
+        break;
+    case Record::SetScissorRegion:
+        if (size < 16) return;
+        target.SetScissorRegion(read<int32_t>(payload, 0), read<int32_t>(payload, 4), read<int32_t>(payload, 8), read<int32_t>(payload, 12));
+        break;
+    case Record::LoadTexture: {
+        if (size < 20) return;
+        const uint32_t length = read<uint32_t>(payload, 16);
+        if (20 + size_t(length) > size) return;
+
+        const std::string source(reinterpret_cast<const char *>(payload + 20), length);
+        Rocket::Core::Vector2i dimensions(read<int32_t>(payload, 8), read<int32_t>(payload, 12));
+        Rocket::Core::TextureHandle handle = 0;
+        Rocket::Core::Vector2i loaded;
+        if (!target.LoadTexture(handle, loaded, source.c_str())) {
+            // Not on this machine: a blank image of the recorded size costs the same to upload
+            if (dimensions.x < 1 || dimensions.y < 1) return;
+            std::vector<Rocket::Core::byte> blank(size_t(dimensions.x) * dimensions.y * sizeof(uint32_t), 0xff);
+            if (!target.GenerateTexture(handle, blank.data(), dimensions)) return;
+        }
+        addReference(_textures, read<uint64_t>(payload, 0), handle);
+        break;
+    }
+    case Record::GenerateTexture: {
+        if (size < 16) return;
+        const Rocket::Core::Vector2i dimensions(read<int32_t>(payload, 8), read<int32_t>(payload, 12));
+        if (dimensions.x < 1 || dimensions.y < 1 || 16 + size_t(dimensions.x) * dimensions.y * sizeof(uint32_t) > size) return;
+
+        Rocket::Core::TextureHandle handle = 0;
+        if (target.GenerateTexture(handle, payload + 16, dimensions)) {
+            addReference(_textures, read<uint64_t>(payload, 0), handle);
+        }
+        break;
+    }
+    case Record::ReleaseTexture: {
+        if (size < 8) return;
+        auto mapped = _textures.find(read<uint64_t>(payload, 0));
+        if (mapped != _textures.end()) {
+            target.ReleaseTexture(mapped->second.handle);
+            if (--mapped->second.references == 0) {
+                _textures.erase(mapped);
+            }
+        }
+        break;
+    }
+    case Record::Frame:
+    default:
+        break;
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "RocketBgfxMappedFile.hpp"
+
+#include <Rocket/Core/RenderInterface.h>
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Capture of a RenderInterface call stream, so a frame produced in the field can be replayed without libRocket or the
+// documents behind it.
+//
+// The file is a "RBGC" header followed by records of { uint32 type, uint32 payload bytes, payload }. Payloads are
+// padded to 4 bytes, so the vertex and index arrays in a mapped capture are aligned and can be handed to the
+// interface in place. Vertices are stored as Rocket::Core::Vertex and everything is in the writer's byte order.
+// Handles are the ones the recording interface returned; the replayer maps them to its own.
+class RocketBgfxCapture
+{
+public:
+    enum class Record : uint32_t {
+        RenderGeometry = 1,         // u32 vertices, u32 indices, u64 texture, f32 x, f32 y, Vertex[], int32[]
+        CompileGeometry,            // u64 geometry, u32 vertices, u32 indices, u64 texture, Vertex[], int32[]
+        RenderCompiledGeometry,     // u64 geometry, f32 x, f32 y
+        ReleaseCompiledGeometry,    // u64 geometry
+        EnableScissorRegion,        // u32 enable
+        SetScissorRegion,           // i32 x, i32 y, i32 width, i32 height
+        LoadTexture,                // u64 texture, i32 width, i32 height, u32 length, char[]
+        GenerateTexture,            // u64 texture, i32 width, i32 height, RGBA8[]
+        ReleaseTexture,             // u64 texture
+        Frame,                      // end of a frame
+    };
+
+    constexpr static const uint32_t MAGIC = 0x43474252;    // "RBGC"
+    constexpr static const uint32_t VERSION = 1;
+};
+
+// Appends calls to a capture file. Owned by RocketBgfxInterface while it records.
+class RocketBgfxCaptureWriter
+{
+public:
+    explicit RocketBgfxCaptureWriter(const std::string & path);
+    ~RocketBgfxCaptureWriter();
+
+    bool isOpen() const noexcept { return _file.is_open(); }
+    uint64_t bytesWritten() const noexcept { return _bytesWritten; }
+
+    void renderGeometry(const Rocket::Core::Vertex * vertices, int num_vertices, const int * indices, int num_indices,
+        Rocket::Core::TextureHandle texture, const Rocket::Core::Vector2f & translation);
+    void compileGeometry(Rocket::Core::CompiledGeometryHandle geometry, const Rocket::Core::Vertex * vertices, int num_vertices,
+        const int * indices, int num_indices, Rocket::Core::TextureHandle texture);
+    void renderCompiledGeometry(Rocket::Core::CompiledGeometryHandle geometry, const Rocket::Core::Vector2f & translation);
+    void releaseCompiledGeometry(Rocket::Core::CompiledGeometryHandle geometry);
+    void enableScissorRegion(bool enable);
+    void setScissorRegion(int x, int y, int width, int height);
+    void loadTexture(Rocket::Core::TextureHandle texture, const Rocket::Core::Vector2i & dimensions, const Rocket::Core::String & source);
+    void generateTexture(Rocket::Core::TextureHandle texture, const Rocket::Core::byte * source, const Rocket::Core::Vector2i & dimensions);
+    void releaseTexture(Rocket::Core::TextureHandle texture);
+    void frame();
+
+private:
+    void begin(RocketBgfxCapture::Record type, size_t payload);
+    void write(const void * data, size_t size);
+    template <typename T> void write(const T & value) { write(&value, sizeof(T)); }
+    void pad(size_t size);
+
+    RocketBgfxCaptureWriter(const RocketBgfxCaptureWriter&) = delete; // non construction-copyable
+    RocketBgfxCaptureWriter& operator=(const RocketBgfxCaptureWriter&) = delete; // non copyable
+
+    std::ofstream _file;
+    uint64_t      _bytesWritten;
+    std::mutex    _mutex;           // recording threads of a threaded interface write records whole
+};
+
+// Feeds a mapped capture back into a render interface, one recorded frame at a time
+class RocketBgfxCaptureReplayer
+{
+public:
+    explicit RocketBgfxCaptureReplayer(const std::string & path);
+    ~RocketBgfxCaptureReplayer();
+
+    bool isOpen() const noexcept { return _valid; }
+
+    /// Replay the calls up to the end of the next recorded frame; the caller then finishes the frame on its
+    /// interface (RocketBgfxInterface::frame()). Returns false once the capture is exhausted.
+    bool replayFrame(Rocket::Core::RenderInterface & target);
+
+    /// Release everything the replay created and still holds on target, then start over from the first frame
+    void rewind(Rocket::Core::RenderInterface & target);
+
+    uint32_t framesReplayed() const noexcept { return _frames; }
+
+private:
+    // A recorded handle the recording interface returned `references` times, e.g. for identical compiles it shared
+    struct Mapped {
+        uintptr_t handle;
+        uint32_t  references;
+    };
+
+    void replay(RocketBgfxCapture::Record type, const uint8_t * payload, uint32_t size, Rocket::Core::RenderInterface & target);
+    uintptr_t texture(uint64_t recorded) const;
+    static void addReference(std::unordered_map<uint64_t, Mapped> & mapping, uint64_t recorded, uintptr_t handle);
+
+    RocketBgfxCaptureReplayer(const RocketBgfxCaptureReplayer&) = delete; // non construction-copyable
+    RocketBgfxCaptureReplayer& operator=(const RocketBgfxCaptureReplayer&) = delete; // non copyable
+
+    RocketBgfxMappedFile                     _file;
+    bool                                     _valid;
+    size_t                                   _cursor;
+    uint32_t                                 _frames;
+    std::unordered_map<uint64_t, Mapped>     _geometry;     // recorded -> replayed handles
+    std::unordered_map<uint64_t, Mapped>     _textures;
+};
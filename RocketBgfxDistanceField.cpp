@@ -0,0 +1,43 @@
+#include "RocketBgfxDistanceField.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Brute force over a (2 * SPREAD + 1)^2 window, which is cheap at this spread and runs once per page. Partly covered
+// texels sit on the edge, their coverage places it within the texel; everything else is as far from the edge as the
+// nearest texel on the other side of it, minus the half texel to that texel's boundary.
+void RocketBgfxDistanceField::generate(const uint8_t * rgba, int width, int height, std::vector<uint8_t> & field) {
+    field.resize(size_t(width) * height);
+    auto alpha = [rgba, width](int x, int y) { return rgba[(size_t(y) * width + x) * 4 + 3]; };
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const uint8_t coverage = alpha(x, y);
+            float distance;
+            if (coverage > 0 && coverage < 255) {
+                distance = coverage / 255.0f - 0.5f;
+            }
+            else {
+                const bool inside = coverage == 255;
+                int nearest = (SPREAD + 1) * (SPREAD + 1) * 2;
+                for (int dy = -SPREAD; dy <= SPREAD; ++dy) {
+                    const int sy = y + dy;
+                    if (sy < 0 || sy >= height)
+                        continue;
+                    for (int dx = -SPREAD; dx <= SPREAD; ++dx) {
+                        const int sx = x + dx;
+                        if (sx < 0 || sx >= width || dx * dx + dy * dy >= nearest)
+                            continue;
+                        if ((alpha(sx, sy) >= 128) != inside) {
+                            nearest = dx * dx + dy * dy;
+                        }
+                    }
+                }
+                const float magnitude = std::min(std::sqrt(float(nearest)) - 0.5f, float(SPREAD));
+                distance = inside ? magnitude : -magnitude;
+            }
+            const float value = 128.0f + distance * (127.0f / SPREAD);
+            field[size_t(y) * width + x] = static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, value + 0.5f)));
+        }
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Turns libRocket's glyph pages into single-channel signed distance fields. libRocket rasterizes glyphs as white texels
+// whose alpha is the coverage and tints them through the vertex color, so the alpha channel is all there is to a page.
+// A distance field of it keeps edges sharp under magnification and lets the shader draw outlines and shadows.
+class RocketBgfxDistanceField
+{
+public:
+    // Texels from the edge at which the field saturates. Glyphs are packed with little padding, so more would only
+    // measure distances to the neighbouring glyphs.
+    constexpr static const int SPREAD = 4;
+
+    /// One byte per texel of a white RGBA8 page (RocketBgfxSimd::isWhite): 128 on the edge, rising inside and falling outside by 127 / SPREAD per texel
+    static void generate(const uint8_t * rgba, int width, int height, std::vector<uint8_t> & field);
+};
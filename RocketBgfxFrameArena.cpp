@@ -0,0 +1,91 @@
+#include "RocketBgfxFrameArena.hpp"
+
+#include <algorithm>
+
+void RocketBgfxFrameArena::destroy() {
+    bool last;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (Block * block : _pool) {
+            _stats.blocks--;
+            _stats.blockBytes -= block->capacity;
+            freeBlock(block);
+        }
+        _pool.clear();
+        _destroyed = true;
+        last = _stats.blocks == 0;
+    }
+    if (last) delete this;
+}
+RocketBgfxFrameArena::Stats RocketBgfxFrameArena::getStats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+// The largest pooled block, which is the one most likely to last the whole frame. Growing arrays ask for twice their
+// current block, so a frame larger than the pool's blocks settles after a few doublings.
+RocketBgfxFrameArena::Block * RocketBgfxFrameArena::acquire(size_t bytes, size_t preferred) {
+    const size_t minimum = MIN_BLOCK_BYTES;
+    const size_t capacity = std::max(std::max(bytes, preferred), minimum);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto largest = std::max_element(_pool.begin(), _pool.end(), [](const Block * a, const Block * b) { return a->capacity < b->capacity; });
+        if (largest != _pool.end() && (*largest)->capacity >= bytes) {
+            Block * block = *largest;
+            _pool.erase(largest);
+            block->references = 1;
+            return block;
+        }
+        _stats.blocks++;
+        _stats.blockBytes += capacity;
+        _stats.blockAllocations++;
+    }
+
+    Block * block = new Block;
+    block->data = new uint8_t[capacity];
+    block->capacity = capacity;
+    block->references = 1;
+    block->arena = this;
+    return block;
+}
+const bgfx::Memory * RocketBgfxFrameArena::lend(Block * block, size_t bytes) {
+    block->references++;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.bytesLent += bytes;
+    }
+    return bgfx::makeRef(block->data, static_cast<uint32_t>(bytes), releaseLent, block);
+}
+void RocketBgfxFrameArena::releaseLent(void *, void * block) {
+    Block * lent = static_cast<Block *>(block);
+    lent->arena->release(lent);
+}
+void RocketBgfxFrameArena::release(Block * block) noexcept {
+    if (--block->references != 0)
+        return;
+
+    bool last = false;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Block * freed = block;
+        if (!_destroyed) {
+            _pool.push_back(block);
+            freed = nullptr;
+            if (_pool.size() > MAX_POOLED_BLOCKS) {
+                auto smallest = std::min_element(_pool.begin(), _pool.end(), [](const Block * a, const Block * b) { return a->capacity < b->capacity; });
+                freed = *smallest;
+                _pool.erase(smallest);
+            }
+        }
+        if (freed) {
+            _stats.blocks--;
+            _stats.blockBytes -= freed->capacity;
+            freeBlock(freed);
+            last = _destroyed && _stats.blocks == 0;
+        }
+    }
+    if (last) delete this;
+}
+void RocketBgfxFrameArena::freeBlock(Block * block) noexcept {
+    delete[] block->data;
+    delete block;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <bgfx.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+// Recycled storage for the per-frame geometry streams. An Array grows by bumping into a block from the arena's pool,
+// and lend() hands its contents to bgfx with makeRef instead of copying them. The block goes back to the pool once
+// bgfx calls the release callback and the array has moved on to another block, so steady frames allocate nothing.
+//
+// bgfx may release on its render thread, and after the owner is gone: create() the arena, and destroy() it instead of
+// deleting, it then frees itself with its last block.
+class RocketBgfxFrameArena
+{
+    struct Block {
+        uint8_t *             data;
+        size_t                capacity;
+        std::atomic<uint32_t> references;       // the array using it, plus one per outstanding lend
+        RocketBgfxFrameArena * arena;
+    };
+
+public:
+    struct Stats {
+        uint32_t blocks;                // allocated, in use or pooled
+        uint64_t blockBytes;
+        uint32_t blockAllocations;      // since creation
+        uint64_t bytesLent;             // total handed to bgfx::makeRef
+    };
+
+    // Append-only array of trivially copyable elements, with the subset of std::vector the recorders use. Elements
+    // are not initialized. Arrays default-constructed without an arena can only take blocks through swap().
+    template <typename T>
+    class Array
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "blocks are moved with memcpy");
+
+    public:
+        explicit Array(RocketBgfxFrameArena * arena = nullptr) noexcept : _arena(arena), _block(nullptr), _size(0) {}
+        Array(Array && other) noexcept : _arena(other._arena), _block(other._block), _size(other._size) {
+            other._block = nullptr;
+            other._size = 0;
+        }
+        Array & operator=(Array && other) noexcept {
+            std::swap(_arena, other._arena);
+            swap(other);
+            return *this;
+        }
+        ~Array() { drop(); }
+
+        size_t size() const noexcept { return _size; }
+        bool empty() const noexcept { return _size == 0; }
+        T * data() noexcept { return _block ? reinterpret_cast<T *>(_block->data) : nullptr; }
+        const T * data() const noexcept { return _block ? reinterpret_cast<const T *>(_block->data) : nullptr; }
+        T & operator[](size_t index) noexcept { return data()[index]; }
+        T & back() noexcept { return data()[_size - 1]; }
+
+        void resize(size_t size) {
+            reserve(size);
+            _size = size;
+        }
+        T & emplace_back() {
+            resize(_size + 1);
+            return back();
+        }
+        void push_back(const T & value) { emplace_back() = value; }
+
+        // A lent block keeps its contents for bgfx, the next append starts on another one
+        void clear() noexcept {
+            if (_block && _block->references.load() > 1) {
+                drop();
+            }
+            _size = 0;
+        }
+        // Blocks only, each array keeps its arena
+        void swap(Array & other) noexcept {
+            std::swap(_block, other._block);
+            std::swap(_size, other._size);
+        }
+
+        /// The contents as bgfx memory, valid until bgfx releases it whatever happens to the array. Null when empty.
+        const bgfx::Memory * lend() const {
+            return _size ? _block->arena->lend(_block, _size * sizeof(T)) : nullptr;
+        }
+
+    private:
+        Array(const Array&) = delete; // non construction-copyable
+        Array& operator=(const Array&) = delete; // non copyable
+
+        void reserve(size_t size) {
+            if (_block && size * sizeof(T) <= _block->capacity)
+                return;
+            Block * grown = _arena->acquire(size * sizeof(T), _block ? _block->capacity * 2 : 0);
+            if (_size) {
+                std::memcpy(grown->data, _block->data, _size * sizeof(T));
+            }
+            drop();
+            _block = grown;
+        }
+        void drop() noexcept {
+            if (_block) {
+                _block->arena->release(_block);
+                _block = nullptr;
+            }
+        }
+
+        RocketBgfxFrameArena * _arena;
+        Block *                _block;
+        size_t                 _size;
+    };
+
+    static RocketBgfxFrameArena * create() { return new RocketBgfxFrameArena(); }
+    void destroy();
+
+    Stats getStats() const;
+
+private:
+    // Pooled blocks beyond this many are freed, smallest first
+    constexpr static const size_t MAX_POOLED_BLOCKS = 8;
+    constexpr static const size_t MIN_BLOCK_BYTES = 64 * 1024;
+
+    RocketBgfxFrameArena() : _destroyed(false), _stats() {}
+    ~RocketBgfxFrameArena() = default;
+    RocketBgfxFrameArena(const RocketBgfxFrameArena&) = delete; // non construction-copyable
+    RocketBgfxFrameArena& operator=(const RocketBgfxFrameArena&) = delete; // non copyable
+
+    Block * acquire(size_t bytes, size_t preferred);
+    const bgfx::Memory * lend(Block * block, size_t bytes);
+    void release(Block * block) noexcept;
+    static void releaseLent(void * data, void * block);
+    static void freeBlock(Block * block) noexcept;
+
+    mutable std::mutex   _mutex;
+    std::vector<Block *> _pool;
+    bool                 _destroyed;
+    Stats                _stats;
+};
@@ -0,0 +1,267 @@
+#include "RocketBgfxGeometryArena.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+void RocketBgfxGeometryArena::FreeList::reset(uint32_t capacity) {
+    _blocks.clear();
+    _blocks.push_back({ 0, capacity });
+}
+uint32_t RocketBgfxGeometryArena::FreeList::allocate(uint32_t size, uint32_t below) {
+    for (size_t i = 0; i < _blocks.size() && _blocks[i].offset < below; ++i) {
+        Block & block = _blocks[i];
+        if (block.size < size)
+            continue;
+
+        const uint32_t offset = block.offset;
+        block.offset += size;
+        block.size -= size;
+        if (block.size == 0) {
+            _blocks.erase(_blocks.begin() + i);
+        }
+        return offset;
+    }
+    return UINT32_MAX;
+}
+void RocketBgfxGeometryArena::FreeList::free(uint32_t offset, uint32_t size) {
+    if (size == 0)
+        return;
+
+    auto next = std::lower_bound(_blocks.begin(), _blocks.end(), offset,
+        [](const Block & block, uint32_t value) { return block.offset < value; });
+    next = _blocks.insert(next, Block{ offset, size });
+
+    // Coalesce with the following and then the preceding block
+    if (next + 1 != _blocks.end() && next->offset + next->size == (next + 1)->offset) {
+        next->size += (next + 1)->size;
+        _blocks.erase(next + 1);
+    }
+    if (next != _blocks.begin() && (next - 1)->offset + (next - 1)->size == next->offset) {
+        (next - 1)->size += next->size;
+        _blocks.erase(next);
+    }
+}
+uint32_t RocketBgfxGeometryArena::FreeList::largest() const noexcept {
+    uint32_t largest = 0;
+    for (const auto & block : _blocks) {
+        largest = std::max(largest, block.size);
+    }
+    return largest;
+}
+
+RocketBgfxGeometryArena::RocketBgfxGeometryArena(const bgfx::VertexDecl & decl, uint32_t vertexCapacity, uint32_t indexCapacity, uint32_t framesInFlight)
+    : _decl(decl), _vertexCapacity(vertexCapacity), _indexCapacity(indexCapacity), _framesInFlight(framesInFlight), _frame(0),
+      _compaction(false), _compactionThreshold(0.5f), _compactionMoves(32), _relocations(0), _bytesUploaded(0)
+{
+}
+RocketBgfxGeometryArena::~RocketBgfxGeometryArena() {
+    for (const auto & arena : _arenas) {
+        bgfx::destroyDynamicVertexBuffer(arena.vertexBuffer);
+        bgfx::destroyDynamicIndexBuffer(arena.indexBuffer);
+    }
+    _arenas.clear();
+}
+// First fit across the existing arenas of the right index size; a new one is opened when none has room, sized up for
+// oversized geometry.
+RocketBgfxGeometryArena::Handle RocketBgfxGeometryArena::allocate(const void * vertices, uint32_t numVertices, const void * indices, uint32_t numIndices, bool index32) {
+    const uint16_t indexSize = index32 ? sizeof(uint32_t) : sizeof(uint16_t);
+
+    Allocation allocation = Allocation();
+    size_t arenaIndex = 0;
+    for (; arenaIndex < _arenas.size(); ++arenaIndex) {
+        Arena & arena = _arenas[arenaIndex];
+        if (arena.indexSize != indexSize)
+            continue;
+        if (arena.vertexCapacity - arena.vertexUsed < numVertices || arena.indexCapacity - arena.indexUsed < numIndices)
+            continue;
+
+        allocation.firstVertex = arena.freeVertices.allocate(numVertices);
+        if (allocation.firstVertex == UINT32_MAX)
+            continue;
+
+        allocation.firstIndex = arena.freeIndices.allocate(numIndices);
+        if (allocation.firstIndex == UINT32_MAX) {
+            arena.freeVertices.free(allocation.firstVertex, numVertices);
+            continue;
+        }
+        break;
+    }
+    if (arenaIndex == _arenas.size()) {
+        arenaIndex = createArena(numVertices, numIndices, indexSize);
+        allocation.firstVertex = _arenas[arenaIndex].freeVertices.allocate(numVertices);
+        allocation.firstIndex = _arenas[arenaIndex].freeIndices.allocate(numIndices);
+    }
+
+    Arena & arena = _arenas[arenaIndex];
+    allocation.arena = static_cast<uint16_t>(arenaIndex);
+    allocation.numVertices = numVertices;
+    allocation.numIndices = numIndices;
+    arena.vertexUsed += numVertices;
+    arena.indexUsed += numIndices;
+
+    if (!arena.vertexShadow.empty()) {
+        const uint16_t stride = _decl.getStride();
+        std::memcpy(&arena.vertexShadow[size_t(allocation.firstVertex) * stride], vertices, size_t(numVertices) * stride);
+        std::memcpy(&arena.indexShadow[size_t(allocation.firstIndex) * indexSize], indices, size_t(numIndices) * indexSize);
+    }
+    upload(arena, allocation.firstVertex, vertices, numVertices, allocation.firstIndex, indices, numIndices);
+
+    return _allocations.insert(allocation);
+}
+void RocketBgfxGeometryArena::release(Handle handle) {
+    const Allocation * allocation = _allocations.find(handle);
+    if (!allocation)
+        return;
+
+    _pendingFrees.push_back({ *allocation, _frame });
+    _allocations.erase(handle);
+}
+bool RocketBgfxGeometryArena::resolve(Handle handle, Range & range) const noexcept {
+    const Allocation * allocation = _allocations.find(handle);
+    if (!allocation)
+        return false;
+
+    const Arena & arena = _arenas[allocation->arena];
+    range.vertexBuffer = arena.vertexBuffer;
+    range.indexBuffer = arena.indexBuffer;
+    range.firstVertex = allocation->firstVertex;
+    range.numVertices = allocation->numVertices;
+    range.firstIndex = allocation->firstIndex;
+    range.numIndices = allocation->numIndices;
+    return true;
+}
+void RocketBgfxGeometryArena::nextFrame() {
+    ++_frame;
+
+    auto retired = std::partition(_pendingFrees.begin(), _pendingFrees.end(),
+        [this](const PendingFree & pending) { return _frame - pending.frame < _framesInFlight; });
+    for (auto pending = retired; pending != _pendingFrees.end(); ++pending) {
+        freeRanges(pending->allocation);
+    }
+    _pendingFrees.erase(retired, _pendingFrees.end());
+
+    if (_compaction) {
+        compact();
+    }
+}
+void RocketBgfxGeometryArena::setCompaction(bool enabled, float threshold, uint32_t movesPerFrame) noexcept {
+    _compaction = enabled;
+    _compactionThreshold = threshold;
+    _compactionMoves = movesPerFrame;
+}
+RocketBgfxGeometryArena::Stats RocketBgfxGeometryArena::getStats() const noexcept {
+    Stats stats = Stats();
+    stats.arenas = static_cast<uint32_t>(_arenas.size());
+    stats.allocations = static_cast<uint32_t>(_allocations.size());
+    stats.pendingFrees = static_cast<uint32_t>(_pendingFrees.size());
+    stats.relocations = _relocations;
+    stats.bytesUploaded = _bytesUploaded;
+    for (const auto & arena : _arenas) {
+        stats.vertexCapacity += arena.vertexCapacity;
+        stats.vertexUsed += arena.vertexUsed;
+        stats.largestFreeVertexBlock = std::max<uint64_t>(stats.largestFreeVertexBlock, arena.freeVertices.largest());
+        stats.indexCapacity += arena.indexCapacity;
+        stats.indexUsed += arena.indexUsed;
+        stats.largestFreeIndexBlock = std::max<uint64_t>(stats.largestFreeIndexBlock, arena.freeIndices.largest());
+    }
+    return stats;
+}
+size_t RocketBgfxGeometryArena::createArena(uint32_t numVertices, uint32_t numIndices, uint16_t indexSize) {
+    Arena arena;
+    arena.vertexCapacity = std::max(_vertexCapacity, numVertices);
+    arena.indexCapacity = std::max(_indexCapacity, numIndices);
+    arena.vertexUsed = 0;
+    arena.indexUsed = 0;
+    arena.vertexBuffer = bgfx::createDynamicVertexBuffer(arena.vertexCapacity, _decl);
+    arena.indexBuffer = bgfx::createDynamicIndexBuffer(arena.indexCapacity, indexSize == sizeof(uint32_t) ? BGFX_BUFFER_INDEX32 : BGFX_BUFFER_NONE);
+    arena.indexSize = indexSize;
+    arena.freeVertices.reset(arena.vertexCapacity);
+    arena.freeIndices.reset(arena.indexCapacity);
+    if (_compaction) {
+        arena.vertexShadow.resize(size_t(arena.vertexCapacity) * _decl.getStride());
+        arena.indexShadow.resize(size_t(arena.indexCapacity) * indexSize);
+    }
+
+    _arenas.push_back(std::move(arena));
+    return _arenas.size() - 1;
+}
+void RocketBgfxGeometryArena::upload(Arena & arena, uint32_t firstVertex, const void * vertices, uint32_t numVertices, uint32_t firstIndex,
+    const void * indices, uint32_t numIndices)
+{
+    const uint16_t stride = _decl.getStride();
+    if (numVertices) {
+        bgfx::updateDynamicVertexBuffer(arena.vertexBuffer, firstVertex, bgfx::copy(vertices, numVertices * stride));
+        _bytesUploaded += uint64_t(numVertices) * stride;
+    }
+    if (numIndices) {
+        bgfx::updateDynamicIndexBuffer(arena.indexBuffer, firstIndex, bgfx::copy(indices, numIndices * arena.indexSize));
+        _bytesUploaded += uint64_t(numIndices) * arena.indexSize;
+    }
+}
+void RocketBgfxGeometryArena::freeRanges(const Allocation & allocation) {
+    Arena & arena = _arenas[allocation.arena];
+    arena.freeVertices.free(allocation.firstVertex, allocation.numVertices);
+    arena.freeIndices.free(allocation.firstIndex, allocation.numIndices);
+    arena.vertexUsed -= allocation.numVertices;
+    arena.indexUsed -= allocation.numIndices;
+}
+// Move allocations of fragmented arenas down into the first hole below them. The new location has been free for
+// at least framesInFlight frames, and the old one goes through the usual deferred free, so the GPU never sees a
+// range change under it.
+void RocketBgfxGeometryArena::compact() {
+    std::vector<bool> fragmented(_arenas.size(), false);
+    bool any = false;
+    for (size_t i = 0; i < _arenas.size(); ++i) {
+        const Arena & arena = _arenas[i];
+        const uint32_t freeVertices = arena.vertexCapacity - arena.vertexUsed;
+        const uint32_t freeIndices = arena.indexCapacity - arena.indexUsed;
+        const float vertexFragmentation = freeVertices ? 1.0f - float(arena.freeVertices.largest()) / float(freeVertices) : 0.0f;
+        const float indexFragmentation = freeIndices ? 1.0f - float(arena.freeIndices.largest()) / float(freeIndices) : 0.0f;
+        fragmented[i] = !arena.vertexShadow.empty() && std::max(vertexFragmentation, indexFragmentation) > _compactionThreshold;
+        any = any || fragmented[i];
+    }
+    if (!any)
+        return;
+
+    const uint16_t stride = _decl.getStride();
+    uint32_t moves = 0;
+    for (auto & allocation : _allocations) {
+        if (moves >= _compactionMoves)
+            break;
+        if (!fragmented[allocation.arena])
+            continue;
+
+        Arena & arena = _arenas[allocation.arena];
+        Allocation old = allocation;
+        old.numVertices = 0;
+        old.numIndices = 0;
+
+        const uint32_t firstVertex = arena.freeVertices.allocate(allocation.numVertices, allocation.firstVertex);
+        if (firstVertex != UINT32_MAX) {
+            std::memcpy(&arena.vertexShadow[size_t(firstVertex) * stride],
+                &arena.vertexShadow[size_t(allocation.firstVertex) * stride], size_t(allocation.numVertices) * stride);
+            upload(arena, firstVertex, &arena.vertexShadow[size_t(firstVertex) * stride], allocation.numVertices, 0, nullptr, 0);
+            old.firstVertex = allocation.firstVertex;
+            old.numVertices = allocation.numVertices;
+            allocation.firstVertex = firstVertex;
+            arena.vertexUsed += allocation.numVertices;
+        }
+
+        const uint32_t firstIndex = arena.freeIndices.allocate(allocation.numIndices, allocation.firstIndex);
+        if (firstIndex != UINT32_MAX) {
+            std::memcpy(&arena.indexShadow[size_t(firstIndex) * arena.indexSize],
+                &arena.indexShadow[size_t(allocation.firstIndex) * arena.indexSize], size_t(allocation.numIndices) * arena.indexSize);
+            upload(arena, 0, nullptr, 0, firstIndex, &arena.indexShadow[size_t(firstIndex) * arena.indexSize], allocation.numIndices);
+            old.firstIndex = allocation.firstIndex;
+            old.numIndices = allocation.numIndices;
+            allocation.firstIndex = firstIndex;
+            arena.indexUsed += allocation.numIndices;
+        }
+
+        if (old.numVertices || old.numIndices) {
+            _pendingFrees.push_back({ old, _frame });
+            _relocations++;
+            moves++;
+        }
+    }
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <bgfx.h>
+#include <vector>
+
+#include "RocketBgfxSlotMap.hpp"
+
+// Suballocates compiled UI geometry out of a few large dynamic vertex/index buffers instead of a buffer pair per
+// element, so thousands of compiled elements cost a handful of bgfx handles and a re-layout doesn't churn through
+// create/destroy calls. Each arena manages its vertex and index space with a first-fit free list. Releases are
+// deferred until `framesInFlight` frames have passed so the GPU is done with the range before it is reused.
+//
+// With compaction enabled, nextFrame() moves a bounded number of allocations per frame into lower free blocks of
+// fragmented arenas. That needs a CPU shadow of the arena to copy from, so only arenas opened while compaction is
+// enabled keep one, and only those are compacted. Indices are stored relative to the allocation's first vertex, so
+// moving vertex data never requires rewriting them.
+//
+// Arenas hold either 16-bit or 32-bit indices; geometry only goes into a 32-bit arena when it has more vertices
+// than a 16-bit index can address.
+class RocketBgfxGeometryArena
+{
+public:
+    typedef uint32_t Handle;    // 0 is never a valid allocation
+
+    // Where an allocation currently lives. Only valid until the next nextFrame().
+    struct Range {
+        bgfx::DynamicVertexBufferHandle vertexBuffer;
+        bgfx::DynamicIndexBufferHandle  indexBuffer;
+        uint32_t firstVertex, numVertices;
+        uint32_t firstIndex, numIndices;
+    };
+
+    struct Stats {
+        uint32_t arenas;
+        uint32_t allocations;
+        uint32_t pendingFrees;          // released, waiting for the GPU
+        uint64_t vertexCapacity, vertexUsed, largestFreeVertexBlock;
+        uint64_t indexCapacity, indexUsed, largestFreeIndexBlock;
+        uint32_t relocations;           // total allocations moved by compaction
+        uint64_t bytesUploaded;         // total bytes copied into the arenas, including relocations
+
+        // External fragmentation of the free space, 0 when it is one contiguous block
+        float vertexFragmentation() const noexcept {
+            const uint64_t free = vertexCapacity - vertexUsed;
+            return free ? 1.0f - float(largestFreeVertexBlock) / float(free) : 0.0f;
+        }
+        float indexFragmentation() const noexcept {
+            const uint64_t free = indexCapacity - indexUsed;
+            return free ? 1.0f - float(largestFreeIndexBlock) / float(free) : 0.0f;
+        }
+    };
+
+    RocketBgfxGeometryArena(const bgfx::VertexDecl & decl, uint32_t vertexCapacity = 65536, uint32_t indexCapacity = 196608, uint32_t framesInFlight = 3);
+    ~RocketBgfxGeometryArena();
+
+    /// Copy geometry into an arena. Indices are relative to the first vertex of this allocation, and are 32-bit if
+    /// `index32` is set, 16-bit otherwise.
+    Handle allocate(const void * vertices, uint32_t numVertices, const void * indices, uint32_t numIndices, bool index32 = false);
+    /// Give the allocation back once the GPU can no longer be using it
+    void release(Handle handle);
+    bool resolve(Handle handle, Range & range) const noexcept;
+
+    /// Call once per frame after submitting: retires pending frees and runs a compaction step.
+    void nextFrame();
+
+    /// Relocate live allocations into free holes of arenas whose free space is fragmented beyond the threshold,
+    /// moving at most `movesPerFrame` allocations each frame. Enable it before allocating: arenas opened while it is
+    /// off keep no shadow and are never compacted.
+    void setCompaction(bool enabled, float threshold = 0.5f, uint32_t movesPerFrame = 32) noexcept;
+
+    Stats getStats() const noexcept;
+
+private:
+    struct Block {
+        uint32_t offset, size;
+    };
+
+    // First-fit free list, sorted by offset and coalesced on free
+    class FreeList {
+    public:
+        void reset(uint32_t capacity);
+        uint32_t allocate(uint32_t size, uint32_t below = UINT32_MAX);    // UINT32_MAX when nothing fits
+        void free(uint32_t offset, uint32_t size);
+        uint32_t largest() const noexcept;
+        size_t blocks() const noexcept { return _blocks.size(); }
+    private:
+        std::vector<Block> _blocks;
+    };
+
+    struct Arena {
+        bgfx::DynamicVertexBufferHandle vertexBuffer;
+        bgfx::DynamicIndexBufferHandle  indexBuffer;
+        uint32_t                        vertexCapacity, indexCapacity;
+        uint32_t                        vertexUsed, indexUsed;
+        FreeList                        freeVertices, freeIndices;
+        uint16_t                        indexSize;
+        std::vector<uint8_t>            vertexShadow;   // empty unless opened with compaction enabled
+        std::vector<uint8_t>            indexShadow;
+    };
+
+    struct Allocation {
+        uint16_t arena;
+        uint32_t firstVertex, numVertices;
+        uint32_t firstIndex, numIndices;
+    };
+
+    struct PendingFree {
+        Allocation allocation;
+        uint64_t   frame;
+    };
+
+    size_t createArena(uint32_t numVertices, uint32_t numIndices, uint16_t indexSize);
+    void upload(Arena & arena, uint32_t firstVertex, const void * vertices, uint32_t numVertices, uint32_t firstIndex, const void * indices,
+        uint32_t numIndices);
+    void freeRanges(const Allocation & allocation);
+    void compact();
+
+    RocketBgfxGeometryArena(const RocketBgfxGeometryArena&) = delete; // non construction-copyable
+    RocketBgfxGeometryArena& operator=(const RocketBgfxGeometryArena&) = delete; // non copyable
+
+    const bgfx::VertexDecl &         _decl;
+    uint32_t                         _vertexCapacity;
+    uint32_t                         _indexCapacity;
+    uint32_t                         _framesInFlight;
+    uint64_t                         _frame;
+    std::vector<Arena>               _arenas;
+    RocketBgfxSlotMap<Allocation>    _allocations;
+    std::vector<PendingFree>         _pendingFrees;
+
+    bool                             _compaction;
+    float                            _compactionThreshold;
+    uint32_t                         _compactionMoves;
+    uint32_t                         _relocations;
+    uint64_t                         _bytesUploaded;
+};
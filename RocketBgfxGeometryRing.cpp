@@ -0,0 +1,126 @@
+#include "RocketBgfxGeometryRing.hpp"
+
+#include <algorithm>
+
+namespace {
+    uint32_t nextCapacity(uint32_t current, uint32_t required) {
+        uint32_t capacity = std::max<uint32_t>(current, 1024);
+        while (capacity < required) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+}
+
+// Buffers are created lazily on a slot's first allocation, so the vertex decl only has to be initialized by then.
+RocketBgfxGeometryRing::RocketBgfxGeometryRing(const bgfx::VertexDecl & decl, uint32_t vertexCapacity, uint32_t indexCapacity, uint32_t framesInFlight)
+    : _decl(decl), _slots(std::max<uint32_t>(framesInFlight, 1)), _frame(0), _frameVertices(0), _frameIndices(0),
+      _minVertexCapacity(vertexCapacity), _minIndexCapacity(indexCapacity), _stats()
+{
+    for (auto & slot : _slots) {
+        slot.vertexBuffer = BGFX_INVALID_HANDLE;
+        slot.indexBuffer = BGFX_INVALID_HANDLE;
+        slot.vertexCapacity = 0;
+        slot.indexCapacity = 0;
+        slot.vertexCursor = 0;
+        slot.indexCursor = 0;
+        slot.frame = 0;
+    }
+    _stats.vertexCapacity = vertexCapacity;
+    _stats.indexCapacity = indexCapacity;
+}
+RocketBgfxGeometryRing::~RocketBgfxGeometryRing() {
+    for (auto & slot : _slots) {
+        releaseRetired(slot);
+        if (bgfx::isValid(slot.vertexBuffer)) bgfx::destroyDynamicVertexBuffer(slot.vertexBuffer);
+        if (bgfx::isValid(slot.indexBuffer)) bgfx::destroyDynamicIndexBuffer(slot.indexBuffer);
+    }
+}
+// Live slots that are too small get replaced the next time they become current.
+void RocketBgfxGeometryRing::reserve(uint32_t vertexCapacity, uint32_t indexCapacity) {
+    _minVertexCapacity = std::max(_minVertexCapacity, vertexCapacity);
+    _minIndexCapacity = std::max(_minIndexCapacity, indexCapacity);
+    _stats.vertexCapacity = std::max(_stats.vertexCapacity, _minVertexCapacity);
+    _stats.indexCapacity = std::max(_stats.indexCapacity, _minIndexCapacity);
+}
+// The slot we move into was last written `framesInFlight` frames ago, so anything it retired can go now.
+void RocketBgfxGeometryRing::nextFrame() {
+    _stats.vertexHighWater = std::max(_stats.vertexHighWater, _frameVertices);
+    _stats.indexHighWater = std::max(_stats.indexHighWater, _frameIndices);
+    _frameVertices = 0;
+    _frameIndices = 0;
+
+    ++_frame;
+    Slot & slot = _slots[_frame % _slots.size()];
+    releaseRetired(slot);
+    if (bgfx::isValid(slot.vertexBuffer) && (slot.vertexCapacity < _minVertexCapacity || slot.indexCapacity < _minIndexCapacity)) {
+        bgfx::destroyDynamicVertexBuffer(slot.vertexBuffer);
+        bgfx::destroyDynamicIndexBuffer(slot.indexBuffer);
+        slot.vertexBuffer = BGFX_INVALID_HANDLE;
+        slot.indexBuffer = BGFX_INVALID_HANDLE;
+    }
+    slot.vertexCursor = 0;
+    slot.indexCursor = 0;
+    slot.frame = _frame;
+}
+RocketBgfxGeometryRing::Allocation RocketBgfxGeometryRing::allocate(const bgfx::Memory * vertices, uint32_t numVertices, const bgfx::Memory * indices, uint32_t numIndices) {
+    Slot & slot = _slots[_frame % _slots.size()];
+
+    if (!bgfx::isValid(slot.vertexBuffer)
+        || slot.vertexCursor + numVertices > slot.vertexCapacity
+        || slot.indexCursor + numIndices > slot.indexCapacity) {
+        grow(slot, numVertices, numIndices);
+    }
+
+    Allocation allocation;
+    allocation.vertexBuffer = slot.vertexBuffer;
+    allocation.indexBuffer = slot.indexBuffer;
+    allocation.firstVertex = slot.vertexCursor;
+    allocation.firstIndex = slot.indexCursor;
+
+    if (vertices) {
+        bgfx::updateDynamicVertexBuffer(slot.vertexBuffer, slot.vertexCursor, vertices);
+        _stats.bytesUploaded += vertices->size;
+    }
+    if (indices) {
+        bgfx::updateDynamicIndexBuffer(slot.indexBuffer, slot.indexCursor, indices);
+        _stats.bytesUploaded += indices->size;
+    }
+
+    slot.vertexCursor += numVertices;
+    slot.indexCursor += numIndices;
+    _frameVertices += numVertices;
+    _frameIndices += numIndices;
+
+    return allocation;
+}
+// Start the slot on a fresh buffer pair big enough for the request. Anything already written this frame stays valid
+// in the retired buffers.
+void RocketBgfxGeometryRing::grow(Slot & slot, uint32_t numVertices, uint32_t numIndices) {
+    const bool grown = bgfx::isValid(slot.vertexBuffer);
+    if (grown) {
+        slot.retiredVertexBuffers.push_back(slot.vertexBuffer);
+        slot.retiredIndexBuffers.push_back(slot.indexBuffer);
+        slot.vertexCapacity = nextCapacity(slot.vertexCapacity, slot.vertexCapacity + numVertices);
+        slot.indexCapacity = nextCapacity(slot.indexCapacity, slot.indexCapacity + numIndices);
+        _stats.grows++;
+    }
+    else {
+        slot.vertexCapacity = nextCapacity(_minVertexCapacity, numVertices);
+        slot.indexCapacity = nextCapacity(_minIndexCapacity, numIndices);
+    }
+
+    slot.vertexBuffer = bgfx::createDynamicVertexBuffer(slot.vertexCapacity, _decl);
+    slot.indexBuffer = bgfx::createDynamicIndexBuffer(slot.indexCapacity);
+    slot.vertexCursor = 0;
+    slot.indexCursor = 0;
+
+    _stats.vertexCapacity = std::max(_stats.vertexCapacity, slot.vertexCapacity);
+    _stats.indexCapacity = std::max(_stats.indexCapacity, slot.indexCapacity);
+}
+void RocketBgfxGeometryRing::releaseRetired(Slot & slot) {
+    for (auto handle : slot.retiredVertexBuffers) bgfx::destroyDynamicVertexBuffer(handle);
+    for (auto handle : slot.retiredIndexBuffers) bgfx::destroyDynamicIndexBuffer(handle);
+    slot.retiredVertexBuffers.clear();
+    slot.retiredIndexBuffers.clear();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <bgfx.h>
+#include <vector>
+
+// A ring of frame-tagged dynamic vertex/index buffers for the per-frame UI geometry stream.
+// Each frame writes into its own slot, and a slot is only reused once `framesInFlight` frames have passed, so we
+// never overwrite a region the GPU may still be reading. Slots grow on demand: a full slot moves on to a larger
+// buffer pair and retires the old one until the slot comes around again.
+class RocketBgfxGeometryRing
+{
+public:
+    struct Allocation {
+        bgfx::DynamicVertexBufferHandle vertexBuffer;
+        bgfx::DynamicIndexBufferHandle  indexBuffer;
+        uint32_t                        firstVertex;
+        uint32_t                        firstIndex;
+    };
+
+    struct Stats {
+        uint32_t vertexCapacity;        // per slot
+        uint32_t indexCapacity;
+        uint32_t vertexHighWater;       // largest number of vertices written in a single frame
+        uint32_t indexHighWater;
+        uint32_t grows;                 // times a slot had to move to larger buffers
+        uint64_t bytesUploaded;         // total bytes written into the ring
+    };
+
+    RocketBgfxGeometryRing(const bgfx::VertexDecl & decl, uint32_t vertexCapacity, uint32_t indexCapacity, uint32_t framesInFlight = 3);
+    ~RocketBgfxGeometryRing();
+
+    /// Make sure every slot can hold at least this much geometry, typically with a high-water mark from a previous run.
+    void reserve(uint32_t vertexCapacity, uint32_t indexCapacity);
+
+    /// Move on to the next slot. Call once per frame before allocating.
+    void nextFrame();
+
+    /// Upload the geometry into the current slot and return where it landed. Indices are 16-bit. bgfx takes the memory
+    /// over as with any update, pass null for none.
+    Allocation allocate(const bgfx::Memory * vertices, uint32_t numVertices, const bgfx::Memory * indices, uint32_t numIndices);
+
+    const Stats & getStats() const noexcept { return _stats; }
+
+private:
+    struct Slot {
+        bgfx::DynamicVertexBufferHandle vertexBuffer;
+        bgfx::DynamicIndexBufferHandle  indexBuffer;
+        uint32_t vertexCapacity, indexCapacity;     // of the current buffers, 0 until created
+        uint32_t vertexCursor, indexCursor;
+        uint64_t frame;
+
+        // Buffers outgrown during the slot's frame; they may still be referenced until the slot is recycled
+        std::vector<bgfx::DynamicVertexBufferHandle> retiredVertexBuffers;
+        std::vector<bgfx::DynamicIndexBufferHandle>  retiredIndexBuffers;
+    };
+
+    void grow(Slot & slot, uint32_t numVertices, uint32_t numIndices);
+    void releaseRetired(Slot & slot);
+
+    RocketBgfxGeometryRing(const RocketBgfxGeometryRing&) = delete; // non construction-copyable
+    RocketBgfxGeometryRing& operator=(const RocketBgfxGeometryRing&) = delete; // non copyable
+
+    const bgfx::VertexDecl & _decl;
+    std::vector<Slot>       _slots;
+    uint64_t                _frame;
+    uint32_t                _frameVertices;
+    uint32_t                _frameIndices;
+    uint32_t                _minVertexCapacity;
+    uint32_t                _minIndexCapacity;
+    Stats                   _stats;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 64-bit non-cryptographic content hash (the xxHash64 construction). Four independent lanes consume 32 bytes per
+// step, which keeps hashing a texture or a mesh well below the cost of uploading it.
+class RocketBgfxHash
+{
+public:
+    static uint64_t compute(const void * data, size_t size, uint64_t seed = 0) noexcept {
+        const uint8_t * p = static_cast<const uint8_t *>(data);
+        const uint8_t * const end = p + size;
+        uint64_t h;
+
+        if (size >= 32) {
+            uint64_t lanes[4] = { seed + PRIME1 + PRIME2, seed + PRIME2, seed, seed - PRIME1 };
+            for (; p + 32 <= end; p += 32) {
+                for (int lane = 0; lane < 4; ++lane) {
+                    lanes[lane] = round(lanes[lane], read64(p + lane * 8));
+                }
+            }
+            h = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+            for (int lane = 0; lane < 4; ++lane) {
+                h = (h ^ round(0, lanes[lane])) * PRIME1 + PRIME4;
+            }
+        }
+        else {
+            h = seed + PRIME5;
+        }
+        h += size;
+
+        for (; p + 8 <= end; p += 8) {
+            h = rotl(h ^ round(0, read64(p)), 27) * PRIME1 + PRIME4;
+        }
+        if (p + 4 <= end) {
+            h = rotl(h ^ (uint64_t(read32(p)) * PRIME1), 23) * PRIME2 + PRIME3;
+            p += 4;
+        }
+        for (; p < end; ++p) {
+            h = rotl(h ^ (*p * PRIME5), 11) * PRIME1;
+        }
+
+        h ^= h >> 33;
+        h *= PRIME2;
+        h ^= h >> 29;
+        h *= PRIME3;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    static const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+    static const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+    static const uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+    static const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+    static const uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+    static uint64_t rotl(uint64_t value, int bits) noexcept { return (value << bits) | (value >> (64 - bits)); }
+    static uint64_t round(uint64_t acc, uint64_t input) noexcept { return rotl(acc + input * PRIME2, 31) * PRIME1; }
+    static uint64_t read64(const uint8_t * p) noexcept { uint64_t value; std::memcpy(&value, p, sizeof(value)); return value; }
+    static uint32_t read32(const uint8_t * p) noexcept { uint32_t value; std::memcpy(&value, p, sizeof(value)); return value; }
+};
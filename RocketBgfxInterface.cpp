@@ -1,7 +1,11 @@
 #include "RocketBgfxInterface.hpp"
+#include "RocketBgfxHash.hpp"
 
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <bx/fpumath.h>
 
 #include <stb_image.h>
@@ -10,23 +14,54 @@ using namespace space::Render;
 
 bgfx::VertexDecl space::Render::RocketBgfxInterface::RocketVertexData::ms_decl;
 
+namespace {
+    // The recorder each thread used last, so recording doesn't look its thread up on every call
+    struct RecorderCache {
+        uint64_t instance;
+        void *   recorder;
+    };
+    thread_local RecorderCache t_recorderCache = { 0, nullptr };
+    std::atomic<uint64_t> s_nextInstance(1);
+}
+
 RocketBgfxInterface::RocketBgfxInterface(int viewNumber, float _width, float _height, bool configureView)
-    : _currentTextureIndex(1), _viewNumber(viewNumber), _width(_width), _height(_height)
+    : _colorInstancedShader(bgfx::ProgramHandle{ bgfx::invalidHandle }), _textureInstancedShader(bgfx::ProgramHandle{ bgfx::invalidHandle }),
+      _alphaShader(bgfx::ProgramHandle{ bgfx::invalidHandle }), _distanceFieldShader(bgfx::ProgramHandle{ bgfx::invalidHandle }),
+      _viewNumber(viewNumber), _compiledGeometry(RocketVertexData::ms_decl), _textureAtlasEnabled(true),
+      _textureLoaderThreads(DEFAULT_TEXTURE_LOADER_THREADS), _textureUploadsPerFrame(DEFAULT_TEXTURE_UPLOADS_PER_FRAME),
+      _placeholderTexture(bgfx::TextureHandle{ bgfx::invalidHandle }), _textureCacheStats(), _geometryCacheStats(), _textureLoadStats(),
+      _textureBudget(0), _textureUploadBudget(0), _textureUploadBytes(0), _textureFrame(0), _textureResidencyStats(), _assetBundle(nullptr),
+      _frameArena(RocketBgfxFrameArena::create()), _mainRecorder(_frameArena),
+      _apiThread(std::this_thread::get_id()), _threadedRecording(false), _instance(s_nextInstance++),
+      _frameCommitted(false), _decoupled(false), _framesCommitted(0),
+      _dynamicGeometry(RocketVertexData::ms_decl, DEFAULT_DYNAMIC_VERTICES, DEFAULT_DYNAMIC_INDICES),
+      _width(_width), _height(_height), _viewCulling(false),
+      _layerQuadIndices(bgfx::IndexBufferHandle{ bgfx::invalidHandle }), _firstLayerView(0), _layerViews(0), _layerViewsUsed(0),
+      _layerBudget(DEFAULT_LAYER_BUDGET), _layerFrame(0),
+      _batchStats(), _layerStats(), _frameStats(), _lastFrameStats(), _bytesCopiedSnapshot(0), _trace(nullptr)
 {
     RocketVertexData::init();
     if (configureView) setViewParameters();
-
-    _dynamicVertexBuffer = bgfx::createDynamicVertexBuffer(MAX_DYNAMIC_VERTICES, RocketVertexData::ms_decl);
-    _dynamicIndexBuffer = bgfx::createDynamicIndexBuffer(MAX_DYNAMIC_INDICES, BGFX_BUFFER_INDEX32);
 }
 RocketBgfxInterface::RocketBgfxInterface(int viewNumber, bgfx::ProgramHandle colorShader, bgfx::ProgramHandle textureShader, float _width, float _height, bool configureView)
-    : _colorShader(colorShader), _textureShader(textureShader), _width(_width), _height(_height), _currentTextureIndex(1), _viewNumber(viewNumber), _scissorParams({ false, 0, 0, 0, 0 })
+    : _colorShader(colorShader), _textureShader(textureShader),
+      _colorInstancedShader(bgfx::ProgramHandle{ bgfx::invalidHandle }), _textureInstancedShader(bgfx::ProgramHandle{ bgfx::invalidHandle }),
+      _alphaShader(bgfx::ProgramHandle{ bgfx::invalidHandle }), _distanceFieldShader(bgfx::ProgramHandle{ bgfx::invalidHandle }),
+      _viewNumber(viewNumber), _compiledGeometry(RocketVertexData::ms_decl), _textureAtlasEnabled(true),
+      _textureLoaderThreads(DEFAULT_TEXTURE_LOADER_THREADS), _textureUploadsPerFrame(DEFAULT_TEXTURE_UPLOADS_PER_FRAME),
+      _placeholderTexture(bgfx::TextureHandle{ bgfx::invalidHandle }), _textureCacheStats(), _geometryCacheStats(), _textureLoadStats(),
+      _textureBudget(0), _textureUploadBudget(0), _textureUploadBytes(0), _textureFrame(0), _textureResidencyStats(), _assetBundle(nullptr),
+      _frameArena(RocketBgfxFrameArena::create()), _mainRecorder(_frameArena),
+      _apiThread(std::this_thread::get_id()), _threadedRecording(false), _instance(s_nextInstance++),
+      _frameCommitted(false), _decoupled(false), _framesCommitted(0),
+      _dynamicGeometry(RocketVertexData::ms_decl, DEFAULT_DYNAMIC_VERTICES, DEFAULT_DYNAMIC_INDICES),
+      _width(_width), _height(_height), _viewCulling(false),
+      _layerQuadIndices(bgfx::IndexBufferHandle{ bgfx::invalidHandle }), _firstLayerView(0), _layerViews(0), _layerViewsUsed(0),
+      _layerBudget(DEFAULT_LAYER_BUDGET), _layerFrame(0),
+      _batchStats(), _layerStats(), _frameStats(), _lastFrameStats(), _bytesCopiedSnapshot(0), _trace(nullptr)
 {
     RocketVertexData::init();
     if (configureView) setViewParameters();
-
-    _dynamicVertexBuffer = bgfx::createDynamicVertexBuffer(MAX_DYNAMIC_VERTICES, RocketVertexData::ms_decl);
-    _dynamicIndexBuffer = bgfx::createDynamicIndexBuffer(MAX_DYNAMIC_INDICES, BGFX_BUFFER_INDEX32);
 }
 //
 // We render the librocket UI into a seperate vview, thus keeping it seperated from any other rendering
@@ -42,245 +77,1829 @@ void RocketBgfxInterface::setViewParameters(int viewNumber) {
 
     bgfx::setViewTransform(viewNumber, orthoView, identity);
     bgfx::setViewRect(viewNumber, 0, 0, _width, _height);
+    _viewCulling = true;
+
+    // Rocket relies on painter's order, so bgfx must not re-sort the draws we submit into this view
+    bgfx::setViewSeq(viewNumber, true);
+}
+void RocketBgfxInterface::setInstancedShaders(bgfx::ProgramHandle colorShader, bgfx::ProgramHandle textureShader) noexcept {
+    const bool supported = (bgfx::getCaps()->supported & BGFX_CAPS_INSTANCING) != 0;
+    _colorInstancedShader = supported ? colorShader : bgfx::ProgramHandle{ bgfx::invalidHandle };
+    _textureInstancedShader = supported ? textureShader : bgfx::ProgramHandle{ bgfx::invalidHandle };
 }
 RocketBgfxInterface::~RocketBgfxInterface() {
+    // Stop decoding first, the loader frees whatever was never collected
+    _textureLoader.reset();
+    _pendingTextures.clear();
+
     if (_textureBuffers.size()) {
         for (const auto & buffer : _textureBuffers) {
-            bgfx::destroyTexture(buffer.second);
+            if (!buffer.atlased && !buffer.sharedWith && buffer.handle.idx != _placeholderTexture.idx) {
+                bgfx::destroyTexture(buffer.handle);
+            }
         }
         _textureBuffers.clear();
     }
+    for (const auto & upload : _textureUploads) {
+        if (bgfx::isValid(upload.texture)) bgfx::destroyTexture(upload.texture);
+    }
+    // Released by Rocket, but frame() never got to them
+    for (const auto & texture : _deferredWork.textureDestroys) {
+        bgfx::destroyTexture(texture);
+    }
+    for (const auto & texture : _committedFrame.work.textureDestroys) {
+        bgfx::destroyTexture(texture);
+    }
+    if (bgfx::isValid(_placeholderTexture)) {
+        bgfx::destroyTexture(_placeholderTexture);
+    }
 
-    for (auto item : _geometry) {
-        bgfx::VertexBufferHandle vertexBuffer{ bgfx::invalidHandle };
-        bgfx::IndexBufferHandle indexBuffer{ bgfx::invalidHandle };
-        bgfx::TextureHandle texture{ bgfx::invalidHandle };
+    for (auto & layer : _layers) {
+        destroyLayer(layer.second);
+    }
+    if (bgfx::isValid(_layerQuadIndices)) {
+        bgfx::destroyIndexBuffer(_layerQuadIndices);
+    }
+
+    // The arena owns the GPU buffers of all compiled geometry
+    _geometry.clear();
 
-        std::tie(vertexBuffer, indexBuffer, texture) = item.second;
+    // Goes once the recorders and bgfx let go of its blocks
+    _frameArena->destroy();
+}
+RocketBgfxInterface::Bounds RocketBgfxInterface::computeBounds(const Rocket::Core::Vertex * vertices, int num_vertices) noexcept {
+    Bounds bounds = { 0.0f, 0.0f, 0.0f, 0.0f };
+    if (num_vertices < 1)
+        return bounds;
+
+    float minMax[4];
+    RocketBgfxSimd::bounds(&vertices[0].position, static_cast<size_t>(num_vertices), sizeof(Rocket::Core::Vertex), minMax);
+    bounds = { minMax[0], minMax[1], minMax[2], minMax[3] };
+    return bounds;
+}
+// What quantized positions are made relative to: the draw's own origin while its bounds are within reach of it, else
+// their centre in whole pixels, which keeps the subpixel grid. fits is false when even that can't hold them.
+Rocket::Core::Vector2f RocketBgfxInterface::positionOrigin(const Bounds & bounds, bool & fits) noexcept {
+    fits = bounds.minX >= -MAX_POSITION && bounds.maxX <= MAX_POSITION && bounds.minY >= -MAX_POSITION && bounds.maxY <= MAX_POSITION;
+    if (fits)
+        return Rocket::Core::Vector2f(0.0f, 0.0f);
 
-        bgfx::destroyVertexBuffer(vertexBuffer);
-        bgfx::destroyIndexBuffer(indexBuffer);
+    const Rocket::Core::Vector2f origin(std::floor((bounds.minX + bounds.maxX) * 0.5f + 0.5f), std::floor((bounds.minY + bounds.maxY) * 0.5f + 0.5f));
+    fits = bounds.maxX - origin.x <= MAX_POSITION && origin.x - bounds.minX <= MAX_POSITION
+        && bounds.maxY - origin.y <= MAX_POSITION && origin.y - bounds.minY <= MAX_POSITION;
+    return origin;
+}
+namespace {
+    // Fixed point position, saturated to what the vertex format can hold
+    inline int16_t quantizePosition(float value, int subpixels) noexcept {
+        const float scaled = value * subpixels;
+        return static_cast<int16_t>(scaled < -32767.0f ? -32767.0f : (scaled > 32767.0f ? 32767.0f : scaled + (scaled < 0.0f ? -0.5f : 0.5f)));
+    }
+    // UVs outside [0, 1] are clamped, matching the clamped sampling of every UI texture
+    inline int16_t quantizeUv(float value) noexcept {
+        return static_cast<int16_t>((value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value)) * 32767.0f + 0.5f);
     }
-    _geometry.clear();
 
-    bgfx::destroyDynamicVertexBuffer(_dynamicVertexBuffer);
-    bgfx::destroyDynamicIndexBuffer(_dynamicIndexBuffer);
+    // What identifies a draw inside a layer, besides its vertices
+    struct LayerDrawKey {
+        uint64_t geometry;          // compiled geometry handle, 0 for RenderGeometry
+        uint64_t texture;           // Rocket's handle
+        uint32_t boundTexture;      // the bgfx texture behind it now, which changes when a load finishes
+        float    translation[2];
+        uint16_t scissor[4];
+        uint32_t scissorActive;
+    };
 }
-// Draw and then clear the dynamic geometry queue.
-// @TODO: This is still multiple dynamic geomery draw calls. We need to actually check index/texture buffers and combine them if they match.
-void RocketBgfxInterface::frame() {
-    if (_batchGeometry.size() < 1)
+// Convert Rocket vertices into our quantized GPU layout, applying a translation and mapping UVs into the texture's
+// atlas region. Returns false when a position was out of reach and saturated, see positionOrigin().
+bool RocketBgfxInterface::convertVertices(const Rocket::Core::Vertex * vertices, int num_vertices, const Rocket::Core::Vector2f & translation,
+    const TextureEntry * texture, RocketVertexData * out) noexcept
+{
+    const bool atlased = texture && texture->atlased;
+    bool fits = true;
+    for (int v = 0; v < num_vertices; ++v) {
+        const Rocket::Core::Vertex & in = vertices[v];
+        const float x = in.position.x + translation.x, y = in.position.y + translation.y;
+        fits &= std::fabs(x) <= MAX_POSITION && std::fabs(y) <= MAX_POSITION;
+        out[v].m_position[0] = quantizePosition(x, POSITION_SUBPIXELS);
+        out[v].m_position[1] = quantizePosition(y, POSITION_SUBPIXELS);
+        out[v].m_color[0] = in.colour.red;
+        out[v].m_color[1] = in.colour.green;
+        out[v].m_color[2] = in.colour.blue;
+        out[v].m_color[3] = in.colour.alpha;
+        out[v].m_texCoords[0] = quantizeUv(atlased ? texture->region.mapU(in.tex_coord.x) : in.tex_coord.x);
+        out[v].m_texCoords[1] = quantizeUv(atlased ? texture->region.mapV(in.tex_coord.y) : in.tex_coord.y);
+    }
+    return fits;
+}
+const RocketBgfxInterface::TextureEntry * RocketBgfxInterface::findTexture(Rocket::Core::TextureHandle texture) const noexcept {
+    if (!texture)
+        return nullptr;
+
+    return _textureBuffers.find(static_cast<uint32_t>(texture));
+}
+// The bgfx texture a draw samples. Textures still showing the placeholder are looked up again at submit, frame() may
+// have created or finished loading them by then, and so are those the texture budget may evict.
+bgfx::TextureHandle RocketBgfxInterface::drawTexture(const TextureEntry * texture, uint32_t & lateTexture, Rocket::Core::TextureHandle handle) const noexcept {
+    if (texture && texture->sharedWith) {
+        handle = static_cast<Rocket::Core::TextureHandle>(texture->sharedWith);
+        texture = _textureBuffers.find(texture->sharedWith);
+    }
+    lateTexture = texture && (texture->handle.idx == _placeholderTexture.idx || (_textureBudget && restorable(*texture)))
+        ? static_cast<uint32_t>(handle) : 0;
+    return texture ? texture->handle : bgfx::TextureHandle{ bgfx::invalidHandle };
+}
+// The queue the calling thread records into. Threads other than the API thread get their own on first use.
+RocketBgfxInterface::Recorder & RocketBgfxInterface::recorder() {
+    if (!deferBgfx())
+        return _mainRecorder;
+    if (t_recorderCache.instance == _instance)
+        return *static_cast<Recorder *>(t_recorderCache.recorder);
+
+    std::lock_guard<std::mutex> lock(_recordersMutex);
+    std::unique_ptr<Recorder> & recording = _recorders[std::this_thread::get_id()];
+    if (!recording) {
+        recording.reset(new Recorder(_frameArena));
+        recording->order = static_cast<int>(_recorders.size());
+    }
+    t_recorderCache = { _instance, recording.get() };
+    return *recording;
+}
+// Recording threads can't create bgfx resources, so the placeholder their textures start out as has to exist already
+void RocketBgfxInterface::setThreadedRecording(bool enabled) {
+    if (enabled) placeholderTexture();
+    _threadedRecording = enabled;
+}
+// Carry out the creates recording threads could not make, textures before the geometry drawn with them
+void RocketBgfxInterface::runDeferredCreates(DeferredWork & work) {
+    for (auto & pending : work.textureCreates) {
+        // Recording threads may have released it since
+        if (!_textureBuffers.contains(pending.handle))
+            continue;
+        if (pending.bundled) {
+            createBundleTexture(*pending.bundled, *_textureBuffers.find(pending.handle));
+        }
+        else if (pending.container) {
+            createContainerTexture(std::move(pending.container), pending.containerInfo, *_textureBuffers.find(pending.handle));
+        }
+        else if (overUploadBudget(pending.pixels.size())) {
+            queueTextureUpload(pending.handle, std::move(pending.pixels), pending.width, pending.height, pending.storage);
+        }
+        else if (pending.storage != TextureStorage::Rgba) {
+            createSingleChannelTexture(pending.pixels.data(), pending.width, pending.height, pending.storage, *_textureBuffers.find(pending.handle));
+        }
+        else {
+            createTexture(pending.pixels.data(), pending.width, pending.height, *_textureBuffers.find(pending.handle));
+        }
+    }
+    work.textureCreates.clear();
+
+    for (const auto & pending : work.geometryCreates) {
+        if (!_geometry.contains(pending.handle))
+            continue;
+        auto * compiled = _geometry.find(pending.handle);
+
+        const uint32_t numVertices = static_cast<uint32_t>(pending.vertices.size());
+        compiled->allocation = pending.wideIndices.empty()
+            ? _compiledGeometry.allocate(pending.vertices.data(), numVertices, pending.indices.data(), static_cast<uint32_t>(pending.indices.size()))
+            : _compiledGeometry.allocate(pending.vertices.data(), numVertices, pending.wideIndices.data(), static_cast<uint32_t>(pending.wideIndices.size()), true);
+    }
+    work.geometryCreates.clear();
+}
+// Releases wait until the draws recorded before them are submitted
+void RocketBgfxInterface::runDeferredReleases(DeferredWork & work) {
+    for (const uint32_t handle : work.geometryReleases) {
+        if (!_geometry.contains(handle))
+            continue;
+
+        const RocketBgfxGeometryArena::Handle allocation = _geometry.find(handle)->allocation;
+        if (allocation) _compiledGeometry.release(allocation);
+        _geometry.erase(handle);
+    }
+    work.geometryReleases.clear();
+
+    for (const auto & texture : work.textureDestroys) {
+        destroyTexture(texture);
+    }
+    work.textureDestroys.clear();
+
+    for (const auto & region : work.atlasReleases) {
+        _textureAtlas.release(region);
+    }
+    work.atlasReleases.clear();
+}
+// The API thread's queue and every recording thread's, in recording order
+std::vector<RocketBgfxInterface::Recorder *> RocketBgfxInterface::recordersInOrder() {
+    std::vector<Recorder *> recorders(1, &_mainRecorder);
+    {
+        std::lock_guard<std::mutex> lock(_recordersMutex);
+        for (const auto & recording : _recorders) {
+            recorders.push_back(recording.second.get());
+        }
+    }
+    std::stable_sort(recorders.begin(), recorders.end(), [](const Recorder * a, const Recorder * b) { return a->order < b->order; });
+    return recorders;
+}
+void RocketBgfxInterface::setDecoupledRecording(bool enabled) {
+    if (enabled) {
+        setThreadedRecording(true);
+    }
+    else {
+        // A commit frame() never picked up still carries work that has to happen, its draws are dropped
+        std::lock_guard<std::mutex> commit(_commitMutex);
+        if (_frameCommitted) {
+            DeferredWork & committed = _committedFrame.work;
+            committed.geometryCreates.insert(committed.geometryCreates.end(),
+                std::make_move_iterator(_deferredWork.geometryCreates.begin()), std::make_move_iterator(_deferredWork.geometryCreates.end()));
+            committed.textureCreates.insert(committed.textureCreates.end(),
+                std::make_move_iterator(_deferredWork.textureCreates.begin()), std::make_move_iterator(_deferredWork.textureCreates.end()));
+            committed.geometryReleases.insert(committed.geometryReleases.end(), _deferredWork.geometryReleases.begin(), _deferredWork.geometryReleases.end());
+            committed.textureDestroys.insert(committed.textureDestroys.end(), _deferredWork.textureDestroys.begin(), _deferredWork.textureDestroys.end());
+            committed.atlasReleases.insert(committed.atlasReleases.end(), _deferredWork.atlasReleases.begin(), _deferredWork.atlasReleases.end());
+            std::swap(committed, _deferredWork);
+            _frameCommitted = false;
+            _commitConsumed.notify_all();
+        }
+        _committedFrame = RecordedFrame();
+        _submittedFrame = RecordedFrame();
+    }
+    _decoupled = enabled;
+}
+void RocketBgfxInterface::commitFrame() {
+    if (_capture) _capture->frame();
+
+    std::unique_lock<std::mutex> commit(_commitMutex);
+    _commitConsumed.wait(commit, [this] { return !_frameCommitted; });
+
+    TableWriteLock tables = writeTables();
+    const std::vector<Recorder *> recorders = recordersInOrder();
+    _committedFrame.queues.resize(recorders.size());
+    for (size_t i = 0; i < recorders.size(); ++i) {
+        // Swapping hands the recorder the buffers of the frame before last, emptied but with their capacity
+        Recorder & recording = *recorders[i];
+        Recorder & queue = _committedFrame.queues[i];
+        queue.draws.swap(recording.draws);
+        queue.vertices.swap(recording.vertices);
+        queue.indices.swap(recording.indices);
+        recording.closeLayer();
+        queue.layers.swap(recording.layers);
+        queue.invalidatedLayers.swap(recording.invalidatedLayers);
+        queue.culledDraws = recording.culledDraws;
+        queue.order = recording.order;
+        queue.stats = recording.stats;
+
+        recording.clearDraws();
+        recording.culledDraws = 0;
+        recording.stats = RocketBgfxFrameStats();
+    }
+    std::swap(_committedFrame.work, _deferredWork);
+    _frameCommitted = true;
+    _framesCommitted++;
+}
+// Decoupled frame(): switch to the newest committed frame if there is one, else draw the current one again. Creates and
+// releases lock the tables briefly, the submission itself only shares them with the recording thread.
+void RocketBgfxInterface::drawCommittedFrame() {
+    {
+        std::lock_guard<std::mutex> commit(_commitMutex);
+        if (_frameCommitted) {
+            std::swap(_committedFrame, _submittedFrame);
+            for (Recorder & queue : _committedFrame.queues) {
+                queue.clearDraws();
+            }
+            _frameCommitted = false;
+            _commitConsumed.notify_all();
+        }
+    }
+
+    std::vector<Recorder *> queues;
+    for (Recorder & queue : _submittedFrame.queues) {
+        queues.push_back(&queue);
+    }
+    {
+        TableWriteLock tables = writeTables();
+        finishTextureLoads();
+        runDeferredCreates(_submittedFrame.work);
+        restoreDrawnTextures(queues);
+        uploadTextureRows();
+    }
+    {
+        TableReadLock tables = readTables();
+        submitQueuedDraws(queues);
+    }
+    TableWriteLock tables = writeTables();
+    runDeferredReleases(_submittedFrame.work);
+    enforceTextureBudget();
+    _textureFrame++;
+    _textureUploadBytes = 0;
+    _compiledGeometry.nextFrame();
+}
+// Swap decoded images in for their placeholders, at most _textureUploadsPerFrame of them unless draining. Tickets whose
+// texture was released while it was decoding are simply dropped.
+void RocketBgfxInterface::finishTextureLoads(bool drain) {
+    if (!_textureLoader)
         return;
 
-    for (auto item : _batchGeometry) {
-        const bgfx::Memory * vertexBuffer;
-        const bgfx::Memory * indexBuffer;
-        Rocket::Core::Vector2f translation;
-        bgfx::TextureHandle texture{ bgfx::invalidHandle };
-        bgfx::ProgramHandle _shader = _colorShader;
+    const uint32_t maxUploads = drain ? UINT32_MAX : _textureUploadsPerFrame;
+    RocketBgfxTextureLoader::Result result;
+    for (uint32_t uploads = 0; uploads < maxUploads && _textureLoader->poll(result);) {
+        auto pending = _pendingTextures.find(result.ticket);
+        if (pending == _pendingTextures.end()) {
+            RocketBgfxTextureLoader::freePixels(result.pixels);
+            continue;
+        }
+        _textureLoadStats.decodeNs += result.decodeNs;
+        const uint32_t handle = pending->second;
+        TextureEntry * entry = _textureBuffers.find(handle);
+        _pendingTextures.erase(pending);
+        if (!entry) {
+            RocketBgfxTextureLoader::freePixels(result.pixels);
+            continue;
+        }
+        entry->loadTicket = 0;
 
-        std::tie(vertexBuffer, indexBuffer, texture, translation) = item;
+        // The reserved atlas region was sized from the header, a file changed since then can't go in it
+        if (result.pixels && entry->atlased
+            && (result.width != entry->region.width || result.height != entry->region.height)) {
+            result.error = "IMAGE_CHANGED_WHILE_LOADING";
+            RocketBgfxTextureLoader::freePixels(result.pixels);
+            result.pixels = nullptr;
+        }
+        if (!result.pixels) {
+            // The texture stays a transparent placeholder until Rocket releases it, but the next load retries
+            forgetTextureKeys(handle, *entry);
+            reportTextureLoadFailure(result.source.c_str(), result.error);
+            continue;
+        }
+        const size_t bytes = size_t(result.width) * result.height * sizeof(uint32_t);
+        if (!entry->hashed) {
+            // Restored images are known already. The same pixels under another name are drawn from the texture that
+            // has them, like generateTexture() shares them, unless an atlas region was reserved for this one.
+            const uint64_t hash = RocketBgfxSimd::hash(result.pixels, bytes);
+            const uint32_t shared = entry->atlased ? 0 : findLoadedTexture(hash, result.width, result.height);
+            if (shared) {
+                TextureEntry & existing = *_textureBuffers.find(shared);
+                existing.refCount++;
+                entry->sharedWith = shared;
+                entry->handle = existing.handle;
+                _textureCacheStats.hits++;
+                _textureCacheStats.bytesSaved += bytes;
+                RocketBgfxTextureLoader::freePixels(result.pixels);
+                continue;
+            }
+            registerTextureHash(handle, *entry, hash);
+        }
 
-        bgfx::updateDynamicVertexBuffer(_dynamicVertexBuffer, vertexBuffer);
-        if (indexBuffer != nullptr) {
-            bgfx::updateDynamicIndexBuffer(_dynamicIndexBuffer, indexBuffer);
+        if (entry->atlased) {
+            _textureAtlas.upload(entry->region, result.pixels);
+        }
+        else if (overUploadBudget(bytes)) {
+            queueTextureUpload(handle, std::vector<uint8_t>(result.pixels, result.pixels + bytes), result.width, result.height, TextureStorage::Rgba);
+        }
+        else {
+            createTexture(result.pixels, result.width, result.height, *entry);
+        }
+        _frameStats.textureBytes += bytes;
+        RocketBgfxTextureLoader::freePixels(result.pixels);
+        uploads++;
+    }
+}
+// The texture is created by its first band of rows, its entry shows the placeholder until the last one is in
+void RocketBgfxInterface::queueTextureUpload(uint32_t handle, std::vector<uint8_t> texels, int width, int height, TextureStorage storage) {
+    _textureBuffers.find(handle)->handle = placeholderTexture();
+    _textureResidencyStats.deferredUploads++;
+    _textureResidencyStats.queuedUploads++;
+    _textureResidencyStats.queuedUploadBytes += texels.size();
+    _textureUploads.push_back(TextureUpload{ handle, bgfx::TextureHandle{ bgfx::invalidHandle }, std::move(texels),
+        static_cast<uint16_t>(width), static_cast<uint16_t>(height), 0, storage });
+}
+// Upload queued textures in order, as many rows as fit in what is left of the frame's upload budget but at least one
+// per frame. Textures Rocket released in the meantime are dropped.
+void RocketBgfxInterface::uploadTextureRows() {
+    bool uploaded = false;
+    while (!_textureUploads.empty()) {
+        TextureUpload & upload = _textureUploads.front();
+        const uint32_t pitch = static_cast<uint32_t>(upload.texels.size() / upload.height);
+        if (!_textureBuffers.contains(upload.handle)) {
+            if (bgfx::isValid(upload.texture)) destroyTexture(upload.texture);
+            _textureResidencyStats.queuedUploads--;
+            _textureResidencyStats.queuedUploadBytes -= uint64_t(upload.height - upload.nextRow) * pitch;
+            _textureUploads.pop_front();
+            continue;
         }
-        
-        if (bgfx::isValid(texture)) {
-            bgfx::UniformHandle s_texture0 = bgfx::createUniform("s_texture0", bgfx::UniformType::Uniform1iv);
-            bgfx::setTexture(0, s_texture0, texture);
-            _shader = _textureShader;
+        TextureEntry & entry = *_textureBuffers.find(upload.handle);
+
+        const uint64_t left = !_textureUploadBudget ? UINT64_MAX
+            : _textureUploadBytes < _textureUploadBudget ? _textureUploadBudget - _textureUploadBytes : 0;
+        uint32_t rows = static_cast<uint32_t>(std::min<uint64_t>(left / pitch, upload.height - upload.nextRow));
+        if (!rows) {
+            if (uploaded)
+                break;
+            rows = 1;
         }
 
-        float translationMatrix[16] = { 0 };
-        bx::mtxTranslate(translationMatrix, translation.x, translation.y, 0.0f);
-        bgfx::setTransform(translationMatrix);
+        if (!bgfx::isValid(upload.texture)) {
+            // Created empty, and kept out of sight behind the placeholder
+            const bgfx::TextureHandle shown = entry.handle;
+            if (upload.storage != TextureStorage::Rgba) {
+                createSingleChannelTexture(nullptr, upload.width, upload.height, upload.storage, entry);
+            }
+            else {
+                createTexture(nullptr, upload.width, upload.height, entry);
+            }
+            upload.texture = entry.handle;
+            entry.handle = shown;
+        }
+        const bgfx::Memory * memory = bgfx::copy(&upload.texels[size_t(upload.nextRow) * pitch], rows * pitch);
+        bgfx::updateTexture2D(upload.texture, 0, 0, upload.nextRow, upload.width, static_cast<uint16_t>(rows), memory);
+        _frameStats.bytesCopied += memory->size;
+        _textureUploadBytes += memory->size;
+        _textureResidencyStats.queuedUploadBytes -= memory->size;
+        upload.nextRow = static_cast<uint16_t>(upload.nextRow + rows);
+        uploaded = true;
+        if (upload.nextRow < upload.height)
+            break;
 
-        bgfx::setProgram(_shader);
-        bgfx::setState(BGFX_STATE_RGB_WRITE
-            | BGFX_STATE_ALPHA_WRITE
-            | BGFX_STATE_MSAA
-            | BGFX_STATE_BLEND_NORMAL);
-        bgfx::submit(_viewNumber);
+        entry.handle = upload.texture;
+        _textureResidencyStats.queuedUploads--;
+        _textureUploads.pop_front();
+    }
+}
+// Stamp every texture the budget covers with the frame it is drawn in, and create the evicted ones among them again
+// before the draws go out. Draws of those textures always carry their Rocket handle, see drawTexture().
+void RocketBgfxInterface::restoreDrawnTextures(const std::vector<Recorder *> & recorders) {
+    for (const Recorder * recording : recorders) {
+        for (const DrawRecord & draw : recording->draws) {
+            const uint32_t texture = sharedTexture(draw.lateTexture);
+            if (!texture || !_textureBuffers.contains(texture))
+                continue;
 
-        
+            TextureEntry & entry = *_textureBuffers.find(texture);
+            entry.lastDrawn = _textureFrame;
+            if (entry.evicted) {
+                restoreTexture(texture, entry);
+            }
+        }
     }
+}
+// Generated textures come back from their copy, bundled ones from the bundle and KTX/DDS files are mapped again, all
+// right away. Images are decoded again like LoadTexture would, on the loader threads when there are any. A source that
+// is gone now fails the load the way LoadTexture reports it, and the texture stays a placeholder.
+void RocketBgfxInterface::restoreTexture(uint32_t handle, TextureEntry & entry) {
+    entry.evicted = false;
+    _textureResidencyStats.evicted--;
+    _textureResidencyStats.restores++;
+
+    if (!entry.retained.empty()) {
+        if (entry.storage != TextureStorage::Rgba) {
+            createSingleChannelTexture(entry.retained.data(), entry.width, entry.height, entry.storage, entry);
+        }
+        else {
+            createTexture(entry.retained.data(), entry.width, entry.height, entry);
+        }
+        return;
+    }
+    const RocketBgfxBundle::Asset * asset = _assetBundle ? _assetBundle->find(entry.source) : nullptr;
+    if (asset && (asset->kind == RocketBgfxBundle::Kind::Image || RocketBgfxTextureContainer::isContainerPath(entry.source))) {
+        createBundleTexture(*asset, entry);
+        return;
+    }
+
+    const std::string source = entry.source;
+    std::string error;
+    if (RocketBgfxTextureContainer::isContainerPath(source)) {
+        std::unique_ptr<RocketBgfxMappedFile> file;
+        RocketBgfxTextureContainer::Info info;
+        if (openContainer(source, file, info, error)) {
+            createContainerTexture(std::move(file), info, entry);
+            return;
+        }
+    }
+    else if (_textureLoaderThreads) {
+        if (!_textureLoader) {
+            _textureLoader.reset(new RocketBgfxTextureLoader(_textureLoaderThreads));
+        }
+        entry.loadTicket = _textureLoader->request(source);
+        _pendingTextures[entry.loadTicket] = handle;
+        return;
+    }
+    else {
+        int w = 0, h = 0, channels = 0;
+        unsigned char * pixels = stbi_load(source.c_str(), &w, &h, &channels, STBI_rgb_alpha);
+        if (pixels && w && h) {
+            createTexture(pixels, w, h, entry);
+            RocketBgfxTextureLoader::freePixels(pixels);
+            return;
+        }
+        RocketBgfxTextureLoader::freePixels(pixels);
+        const char * reason = stbi_failure_reason();
+        error = reason ? reason : "FAILED_TO_LOAD_IMAGE_FROM_FILE";
+    }
+    forgetTextureKeys(handle, entry);
+    reportTextureLoadFailure(source.c_str(), error);
+}
+// Destroy the least recently drawn textures that can be created again until the rest fit in the budget. Textures drawn
+// this frame stay, so a frame that draws more than the budget holds simply goes over it.
+void RocketBgfxInterface::enforceTextureBudget() {
+    if (!_textureBudget || _textureLoadStats.textureBytes <= _textureBudget)
+        return;
+
+    std::vector<TextureEntry *> victims;
+    for (TextureEntry & entry : _textureBuffers) {
+        if (restorable(entry) && entry.handle.idx != _placeholderTexture.idx && entry.lastDrawn < _textureFrame) {
+            victims.push_back(&entry);
+        }
+    }
+    std::sort(victims.begin(), victims.end(), [](const TextureEntry * a, const TextureEntry * b) { return a->lastDrawn < b->lastDrawn; });
+
+    for (TextureEntry * victim : victims) {
+        if (_textureLoadStats.textureBytes <= _textureBudget)
+            break;
+        destroyTexture(victim->handle);
+        _textureLoadStats.textureBytes -= victim->bytes;
+        victim->bytes = 0;
+        victim->handle = placeholderTexture();
+        victim->evicted = true;
+        _textureResidencyStats.evictions++;
+        _textureResidencyStats.evicted++;
+    }
+}
+// Finish pending texture loads and the work recording threads deferred, restore and upload the textures the frame
+// needs, draw and clear the geometry queues, evict textures over the budget, then publish the frame's statistics. The
+// compiled geometry arena only advances once everything is submitted, as compaction may move the ranges the queued
+// draws refer to.
+void RocketBgfxInterface::frame() {
+    if (_capture && !_decoupled) _capture->frame();
+    {
+        RocketBgfxScopedTimer timer(_frameStats.frameNs, _trace, "RocketBgfxInterface::frame");
+        if (_decoupled) {
+            drawCommittedFrame();
+        }
+        else {
+            TableWriteLock tables = writeTables();
+            finishTextureLoads();
+            runDeferredCreates(_deferredWork);
+
+            const std::vector<Recorder *> recorders = recordersInOrder();
+            restoreDrawnTextures(recorders);
+            uploadTextureRows();
+            submitQueuedDraws(recorders);
+            for (Recorder * recording : recorders) {
+                recording->clearDraws();
+            }
+
+            runDeferredReleases(_deferredWork);
+            enforceTextureBudget();
+            _textureFrame++;
+            _textureUploadBytes = 0;
+            _compiledGeometry.nextFrame();
+        }
+    }
+    publishFrameStats();
+}
+uint64_t RocketBgfxInterface::componentBytesCopied() const noexcept {
+    return _compiledGeometry.getStats().bytesUploaded
+        + _textureAtlas.getStats().bytesUploaded;
+}
+// Hand the finished frame's counters out and start the next one. Uploads made by the geometry and atlas components
+// are picked up from their running totals.
+void RocketBgfxInterface::publishFrameStats() {
+    const uint64_t bytesCopied = componentBytesCopied();
+    _frameStats.bytesCopied += bytesCopied - _bytesCopiedSnapshot;
+    _bytesCopiedSnapshot = bytesCopied;
+    _frameStats.drawCalls = _batchStats.submittedDraws;
+    _frameStats.scissorChanges = _batchStats.scissorChanges;
+
+    _lastFrameStats = _frameStats;
+    _frameStats = RocketBgfxFrameStats();
+
+    if (_trace) {
+        const uint64_t now = RocketBgfxTrace::now();
+        _trace->counter("RocketBgfx draw calls", "draws", _lastFrameStats.drawCalls, now);
+        _trace->counter("RocketBgfx bytes copied", "bytes", double(_lastFrameStats.bytesCopied), now);
+    }
+}
+// Draw the given queues in order. A UI frame only has a handful of distinct clip rects, so they share one linear
+// scissor cache. The recording counters and layer invalidations are picked up on the way, only the first time a queue
+// is drawn.
+void RocketBgfxInterface::submitQueuedDraws(const std::vector<Recorder *> & recorders) {
+    _batchStats = BatchStats();
+    _dynamicGeometry.nextFrame();
+    _layerViewsUsed = 0;
+    _layerFrame++;
+
+    ScissorCache scissorCache;
+    _submitter.begin(static_cast<uint8_t>(_viewNumber));
+    for (Recorder * recording : recorders) {
+        _batchStats.culledDraws += recording->culledDraws;
+        recording->culledDraws = 0;
+        _frameStats += recording->stats;
+        recording->stats = RocketBgfxFrameStats();
+
+        recording->closeLayer();
+        for (const uint32_t id : recording->invalidatedLayers) {
+            auto layer = _layers.find(id);
+            if (layer != _layers.end()) layer->second.valid = false;
+        }
+        recording->invalidatedLayers.clear();
+
+        if (!recording->draws.empty()) {
+            submitRecorder(*recording, scissorCache);
+        }
+    }
+
+    const RocketBgfxSubmitter::Stats & submitStats = _submitter.getStats();
+    _batchStats.submittedDraws = submitStats.submits;
+    _batchStats.programChanges = submitStats.programChanges;
+    _batchStats.textureChanges = submitStats.textureChanges;
+    _batchStats.uniformUpdates = submitStats.uniformUpdates;
+    _batchStats.avoidedStateChanges = submitStats.avoidedStateChanges;
+}
+// One queue's draws. Its dynamic geometry was baked into one vertex/index stream by RenderGeometry, so it is uploaded
+// once into this frame's slot of the geometry ring (which never touches memory the GPU may still be reading). The
+// streams are lent to bgfx rather than copied, clearing the queue moves it on to other blocks. Layers cover ascending,
+// disjoint ranges of the draws.
+void RocketBgfxInterface::submitRecorder(const Recorder & recording, ScissorCache & scissorCache) {
+    const std::vector<DrawRecord> & draws = recording.draws;
+    _batchStats.queuedDraws += static_cast<uint32_t>(draws.size());
+
+    const uint32_t numVertices = static_cast<uint32_t>(recording.vertices.size());
+    RocketBgfxGeometryRing::Allocation dynamic = _dynamicGeometry.allocate(
+        recording.vertices.lend(), numVertices,
+        recording.indices.lend(), static_cast<uint32_t>(recording.indices.size()));
+    _frameStats.verticesUploaded += numVertices;
+    _frameStats.indicesUploaded += static_cast<uint32_t>(recording.indices.size());
+    _frameStats.bytesReferenced += recording.vertices.size() * sizeof(RocketVertexData) + recording.indices.size() * sizeof(uint16_t);
+
+    size_t next = 0;
+    for (const LayerSpan & span : recording.layers) {
+        submitDraws(draws, next, span.firstDraw, dynamic, numVertices, nullptr, scissorCache);
+        if (!drawLayer(span, recording, dynamic, numVertices, scissorCache)) {
+            submitDraws(draws, span.firstDraw, span.endDraw, dynamic, numVertices, nullptr, scissorCache);
+        }
+        next = span.endDraw;
+    }
+    submitDraws(draws, next, draws.size(), dynamic, numVertices, nullptr, scissorCache);
+}
+// Submit a range of a queue's draws. Consecutive dynamic draws sharing a texture (and therefore a program) are merged
+// into a single submit, consecutive draws of the same compiled geometry into one instanced submit. Compiled geometry
+// breaks a dynamic run, which keeps everything in the order Rocket painted it. Every draw carries the scissor that was
+// active when Rocket issued it; identical rects share one entry in bgfx's per-frame scissor cache, inside a layer they
+// move with its origin. Compiled geometry is drawn at its translation through a uniform, see RocketBgfxSubmitter.
+void RocketBgfxInterface::submitDraws(const std::vector<DrawRecord> & draws, size_t first, size_t end, const RocketBgfxGeometryRing::Allocation & dynamic,
+    uint32_t numVertices, const LayerSpan * layer, ScissorCache & scissorCache)
+{
+    for (size_t i = first; i < end; ++i) {
+        DrawRecord draw = draws[i];
+        const bgfx::InstanceDataBuffer * instanceData = nullptr;
+        if (draw.lateTexture && _textureBuffers.contains(draw.lateTexture)) {
+            draw.texture = _textureBuffers.find(sharedTexture(draw.lateTexture))->handle;
+        }
+
+        if (draw.isDynamic()) {
+            // Fold in every following dynamic draw of the same 16-bit segment with the same texture and scissor;
+            // their index ranges are contiguous.
+            while (i + 1 < end
+                && draws[i + 1].isDynamic()
+                && draws[i + 1].firstVertex == draw.firstVertex
+                && draws[i + 1].texture.idx == draw.texture.idx
+                && draws[i + 1].lateTexture == draw.lateTexture
+                && draws[i + 1].scissor == draw.scissor
+                && draws[i + 1].translation == draw.translation) {
+                draw.numIndices += draws[++i].numIndices;
+                _batchStats.mergedDraws++;
+            }
+        }
+        else {
+            // Repeats of the same compiled geometry become instances of one submit, each with its own translation
+            uint32_t repeats = 0;
+            if (instancing() && storageOf(draw.texture) == TextureStorage::Rgba) {
+                while (i + repeats + 1 < end && draws[i].repeats(draws[i + repeats + 1])) {
+                    repeats++;
+                }
+            }
+            if (draw.lateGeometry && !resolveLateGeometry(draw)) {
+                i += repeats;
+                continue;
+            }
+            if (repeats && bgfx::checkAvailInstanceDataBuffer(repeats + 1, INSTANCE_STRIDE)) {
+                instanceData = bgfx::allocInstanceDataBuffer(repeats + 1, INSTANCE_STRIDE);
+                for (uint32_t n = 0; n <= repeats; ++n) {
+                    float * instance = reinterpret_cast<float *>(instanceData->data + n * INSTANCE_STRIDE);
+                    instance[0] = draws[i + n].translation.x;
+                    instance[1] = draws[i + n].translation.y;
+                    instance[2] = 0.0f;
+                    instance[3] = 0.0f;
+                }
+                i += repeats;
+                _batchStats.instancedDraws += repeats;
+            }
+        }
+
+        if (layer && draw.scissor.active()) {
+            // Into the layer's pixels; a rect that misses the layer leaves nothing to draw
+            const int x0 = std::max(int(draw.scissor.x) - layer->x, 0);
+            const int y0 = std::max(int(draw.scissor.y) - layer->y, 0);
+            const int x1 = std::min(int(draw.scissor.x) + int(draw.scissor.width) - layer->x, layer->width);
+            const int y1 = std::min(int(draw.scissor.y) + int(draw.scissor.height) - layer->y, layer->height);
+            if (x1 <= x0 || y1 <= y0)
+                continue;
+            draw.scissor.x = static_cast<uint16_t>(x0);
+            draw.scissor.y = static_cast<uint16_t>(y0);
+            draw.scissor.width = static_cast<uint16_t>(x1 - x0);
+            draw.scissor.height = static_cast<uint16_t>(y1 - y0);
+        }
+
+        if (draw.scissor.active()) {
+            auto cached = std::find_if(scissorCache.begin(), scissorCache.end(),
+                [&draw](const std::pair<viewScissor_t, uint16_t> & entry) { return entry.first == draw.scissor; });
+            if (cached != scissorCache.end()) {
+                bgfx::setScissor(cached->second);
+            }
+            else {
+                scissorCache.push_back(std::make_pair(draw.scissor,
+                    bgfx::setScissor(draw.scissor.x, draw.scissor.y, draw.scissor.width, draw.scissor.height)));
+                _batchStats.scissorChanges++;
+            }
+        }
+
+        if (draw.isDynamic()) {
+            bgfx::setVertexBuffer(dynamic.vertexBuffer, dynamic.firstVertex + draw.firstVertex,
+                std::min(numVertices - draw.firstVertex, uint32_t(MAX_SEGMENT_VERTICES)));
+            bgfx::setIndexBuffer(dynamic.indexBuffer, dynamic.firstIndex + draw.firstIndex, draw.numIndices);
+        }
+        else {
+            bgfx::setVertexBuffer(draw.vertexBuffer, draw.firstVertex, draw.numVertices);
+            bgfx::setIndexBuffer(draw.indexBuffer, draw.firstIndex, draw.numIndices);
+        }
+
+        if (instanceData) {
+            bgfx::setInstanceDataBuffer(instanceData);
+            _submitter.submitInstanced(instancedProgramFor(draw.texture), draw.texture);
+        }
+        else {
+            if (storageOf(draw.texture) == TextureStorage::DistanceField) _submitter.bindDistanceFieldStyle();
+            _submitter.submit(programFor(draw.texture), draw.texture, draw.translation.x, draw.translation.y);
+        }
+    }
+}
+// Composite a layer from its texture, rendering its draws into the texture first unless it still holds them. Returns
+// false when the layer can't be used this frame, for lack of a layer view or of texture budget.
+bool RocketBgfxInterface::drawLayer(const LayerSpan & span, const Recorder & recording, const RocketBgfxGeometryRing::Allocation & dynamic,
+    uint32_t numVertices, ScissorCache & scissorCache)
+{
+    if (span.width < 1 || span.height < 1 || span.width > MAX_LAYER_SIZE || span.height > MAX_LAYER_SIZE) {
+        _layerStats.bypassed++;
+        return false;
+    }
+
+    auto found = _layers.find(span.id);
+    if (found == _layers.end()) {
+        const Layer blank = { BGFX_INVALID_HANDLE, BGFX_INVALID_HANDLE, BGFX_INVALID_HANDLE, 0, 0, 0, false, 0 };
+        found = _layers.emplace(span.id, blank).first;
+    }
+    Layer & layer = found->second;
+    layer.lastUsed = _layerFrame;
+
+    if (layer.valid && layer.signature == span.signature) {
+        _layerStats.hits++;
+    }
+    else {
+        if (_layerViewsUsed >= _layerViews || !allocateLayer(layer, static_cast<uint16_t>(span.width), static_cast<uint16_t>(span.height))) {
+            layer.valid = false;
+            _layerStats.bypassed++;
+            return false;
+        }
+
+        // The interface's projection, narrowed to the layer's rect
+        const uint8_t view = static_cast<uint8_t>(_firstLayerView + _layerViewsUsed++);
+        float orthoView[16] = { 0 };
+        float identity[16] = { 0 };
+        bx::mtxIdentity(identity);
+        bx::mtxOrtho(orthoView, float(span.x), float(span.x + span.width), float(span.y + span.height), float(span.y), -1.0f, 1.0f);
+        bgfx::setViewFrameBuffer(view, layer.frameBuffer);
+        bgfx::setViewRect(view, 0, 0, layer.width, layer.height);
+        bgfx::setViewTransform(view, orthoView, identity);
+        bgfx::setViewClear(view, BGFX_CLEAR_COLOR, 0);
+        bgfx::setViewSeq(view, true);
+
+        _submitter.setTarget(view, RocketBgfxSubmitter::STATE_LAYER);
+        submitDraws(recording.draws, span.firstDraw, span.endDraw, dynamic, numVertices, &span, scissorCache);
+
+        layer.signature = span.signature;
+        layer.valid = true;
+        _layerStats.misses++;
+    }
+
+    _submitter.setTarget(static_cast<uint8_t>(_viewNumber), RocketBgfxSubmitter::STATE_COMPOSITE);
+    bgfx::setVertexBuffer(layer.quad);
+    bgfx::setIndexBuffer(_layerQuadIndices);
+    _submitter.submit(_textureShader, layer.texture, float(span.x), float(span.y));
+    _submitter.setTarget(static_cast<uint8_t>(_viewNumber), RocketBgfxSubmitter::STATE_DEFAULT);
+    return true;
+}
+// Give the layer a texture of its size. The least recently composited layers that aren't in use this frame make room
+// within the budget.
+bool RocketBgfxInterface::allocateLayer(Layer & layer, uint16_t width, uint16_t height) {
+    if (bgfx::isValid(layer.frameBuffer) && layer.width == width && layer.height == height)
+        return true;
+    destroyLayer(layer);
+
+    const uint64_t bytes = uint64_t(width) * height * sizeof(uint32_t);
+    while (_layerStats.textureBytes + bytes > _layerBudget) {
+        Layer * victim = nullptr;
+        for (auto & entry : _layers) {
+            Layer & candidate = entry.second;
+            if (bgfx::isValid(candidate.frameBuffer) && candidate.lastUsed < _layerFrame
+                && (!victim || candidate.lastUsed < victim->lastUsed)) {
+                victim = &candidate;
+            }
+        }
+        if (!victim)
+            return false;
+        destroyLayer(*victim);
+        _layerStats.evictions++;
+    }
+
+    layer.texture = bgfx::createTexture2D(width, height, 1, bgfx::TextureFormat::RGBA8,
+        BGFX_TEXTURE_RT | (BGFX_TEXTURE_U_CLAMP | BGFX_TEXTURE_V_CLAMP) | (BGFX_TEXTURE_MIN_POINT | BGFX_TEXTURE_MAG_POINT));
+    layer.frameBuffer = bgfx::createFrameBuffer(1, &layer.texture, true);
+    layer.width = width;
+    layer.height = height;
+
+    // The quad spans the layer from its origin; OpenGL render targets start at the bottom row
+    const bgfx::RendererType::Enum renderer = bgfx::getRendererType();
+    const bool flipV = renderer == bgfx::RendererType::OpenGL || renderer == bgfx::RendererType::OpenGLES;
+    const bgfx::Memory * memory = bgfx::alloc(4 * sizeof(RocketVertexData));
+    RocketVertexData * corners = reinterpret_cast<RocketVertexData *>(memory->data);
+    for (int corner = 0; corner < 4; ++corner) {
+        const bool right = (corner & 1) != 0;
+        const bool bottom = (corner & 2) != 0;
+        corners[corner].m_position[0] = quantizePosition(right ? float(width) : 0.0f, POSITION_SUBPIXELS);
+        corners[corner].m_position[1] = quantizePosition(bottom ? float(height) : 0.0f, POSITION_SUBPIXELS);
+        for (int channel = 0; channel < 4; ++channel) {
+            corners[corner].m_color[channel] = 255;
+        }
+        corners[corner].m_texCoords[0] = quantizeUv(right ? 1.0f : 0.0f);
+        corners[corner].m_texCoords[1] = quantizeUv(bottom != flipV ? 1.0f : 0.0f);
+    }
+    layer.quad = bgfx::createVertexBuffer(memory, RocketVertexData::ms_decl);
+    _frameStats.bytesCopied += memory->size;
+
+    if (!bgfx::isValid(_layerQuadIndices)) {
+        const uint16_t indices[6] = { 0, 1, 2, 1, 3, 2 };
+        _layerQuadIndices = bgfx::createIndexBuffer(bgfx::copy(indices, sizeof(indices)));
+    }
+
+    _layerStats.textureBytes += bytes;
+    _layerStats.layers++;
+    return true;
+}
+void RocketBgfxInterface::destroyLayer(Layer & layer) {
+    layer.valid = false;
+    if (!bgfx::isValid(layer.frameBuffer))
+        return;
 
-    _batchGeometry.clear();
+    bgfx::destroyFrameBuffer(layer.frameBuffer);    // owns the texture
+    bgfx::destroyVertexBuffer(layer.quad);
+    layer.frameBuffer = BGFX_INVALID_HANDLE;
+    layer.texture = BGFX_INVALID_HANDLE;
+    layer.quad = BGFX_INVALID_HANDLE;
+    _layerStats.textureBytes -= uint64_t(layer.width) * layer.height * sizeof(uint32_t);
+    _layerStats.layers--;
 }
-// This is dynamic geometry, so we use a dynamic buffer for this. Here, we queue the geometry calls into a vector storing its appropriate info
-// At the frame call, we draw the entire collection and clear it.
+// A layer's signature starts from its rect, every draw recorded into it is folded in by signLayerDraw()
+void RocketBgfxInterface::beginLayer(uint32_t id, int x, int y, int width, int height) {
+    Recorder & recording = recorder();
+    recording.closeLayer();
+
+    const int rect[4] = { x, y, width, height };
+    const uint32_t first = static_cast<uint32_t>(recording.draws.size());
+    const LayerSpan span = { id, x, y, width, height, first, first, RocketBgfxHash::compute(rect, sizeof(rect), id) };
+    recording.openLayer = static_cast<int>(recording.layers.size());
+    recording.layers.push_back(span);
+}
+void RocketBgfxInterface::signLayerDraw(Recorder & recording, uint64_t geometry, Rocket::Core::TextureHandle texture, const TextureEntry * entry,
+    const Rocket::Core::Vector2f & translation)
+{
+    if (recording.openLayer < 0)
+        return;
+
+    const viewScissor_t & scissor = recording.scissor;
+    const bool active = scissor.active();
+    LayerDrawKey key;
+    std::memset(&key, 0, sizeof(key));
+    key.geometry = geometry;
+    key.texture = static_cast<uint64_t>(texture);
+    key.boundTexture = entry ? entry->handle.idx : bgfx::invalidHandle;
+    key.translation[0] = translation.x;
+    key.translation[1] = translation.y;
+    if (active) {
+        key.scissor[0] = scissor.x;
+        key.scissor[1] = scissor.y;
+        key.scissor[2] = scissor.width;
+        key.scissor[3] = scissor.height;
+        key.scissorActive = 1;
+    }
+    uint64_t & signature = recording.layers[recording.openLayer].signature;
+    signature = RocketBgfxHash::compute(&key, sizeof(key), signature);
+}
+// Fills in the buffers of a compiled draw that was recorded without them. Geometry that was never uploaded (Rocket
+// released it before frame() got to it) drops the draw.
+bool RocketBgfxInterface::resolveLateGeometry(DrawRecord & draw) const noexcept {
+    RocketBgfxGeometryArena::Range range;
+    if (!_geometry.contains(draw.lateGeometry)
+        || !_compiledGeometry.resolve(_geometry.find(draw.lateGeometry)->allocation, range))
+        return false;
+
+    draw.vertexBuffer = range.vertexBuffer;
+    draw.indexBuffer = range.indexBuffer;
+    draw.firstVertex = range.firstVertex;
+    draw.numVertices = range.numVertices;
+    draw.firstIndex = range.firstIndex;
+    draw.numIndices = range.numIndices;
+    return true;
+}
+// This is dynamic geometry, so we bake its translation into the vertices right away and append it to the calling
+// thread's staging arrays, with 16-bit indices relative to the current segment of the stream. frame() then uploads
+// and draws it in batches. Geometry that lies entirely outside the current scissor or the view never makes it into
+// the stream.
 void RocketBgfxInterface::RenderGeometry(Rocket::Core::Vertex* vertices, int num_vertices, int* indices, int num_indices, Rocket::Core::TextureHandle texture, const Rocket::Core::Vector2f& translation) {
-    
-    const bgfx::Memory * vertexBuffer = nullptr;
-    const bgfx::Memory * indexBuffer = nullptr;
-    bgfx::TextureHandle _texture{ bgfx::invalidHandle };
+    Recorder & recording = recorder();
+    RocketBgfxScopedTimer timer(recording.stats.renderGeometryNs, _trace, "RocketBgfxInterface::RenderGeometry");
+    recording.stats.renderGeometryCalls++;
+    if (_capture) _capture->renderGeometry(vertices, num_vertices, indices, num_indices, texture, translation);
+
+    if (num_vertices < 1)
+        return;
 
-    if (num_indices) {
-        indexBuffer = bgfx::copy(indices, num_indices * sizeof(int));
+    if ((_viewCulling || recording.scissor.active()) && culls(recording, computeBounds(vertices, num_vertices).translated(translation))) {
+        recording.culledDraws++;
+        return;
+    }
+
+    TableReadLock tables = readTables();
+    const TextureEntry * textureEntry = findTexture(texture);
+    if (recording.openLayer >= 0) {
+        uint64_t & signature = recording.layers[recording.openLayer].signature;
+        signature = RocketBgfxSimd::hash(vertices, size_t(num_vertices) * sizeof(Rocket::Core::Vertex), signature);
+        signature = RocketBgfxSimd::hash(indices, size_t(num_indices) * sizeof(int), signature);
+        signLayerDraw(recording, 0, texture, textureEntry, translation);
+    }
+    if (static_cast<uint32_t>(num_vertices) > MAX_SEGMENT_VERTICES) {
+        appendSplitGeometry(recording, vertices, num_vertices, indices, num_indices, textureEntry, texture, translation);
+        return;
     }
-    vertexBuffer = bgfx::copy(vertices, num_vertices * sizeof(Rocket::Core::Vertex));
 
-    if (texture) {
-       _texture = _textureBuffers[texture];
+    // Open a new segment when this draw would index past the end of the current one
+    const uint32_t baseVertex = static_cast<uint32_t>(recording.vertices.size());
+    if (baseVertex + num_vertices - recording.segmentBase > MAX_SEGMENT_VERTICES) {
+        recording.segmentBase = baseVertex;
     }
 
-    _batchGeometry.push_back(std::make_tuple(vertexBuffer, indexBuffer, _texture, translation));
+    DrawRecord draw;
+    draw.vertexBuffer = BGFX_INVALID_HANDLE;
+    draw.indexBuffer = BGFX_INVALID_HANDLE;
+    draw.texture = drawTexture(textureEntry, draw.lateTexture, texture);
+    draw.firstVertex = recording.segmentBase;
+    draw.numVertices = static_cast<uint32_t>(num_vertices);
+    draw.firstIndex = static_cast<uint32_t>(recording.indices.size());
+    draw.numIndices = static_cast<uint32_t>(num_indices ? num_indices : num_vertices);
+    draw.translation = Rocket::Core::Vector2f(0.0f, 0.0f);
+    draw.scissor = recording.scissor;
+    draw.lateGeometry = 0;
+
+    recording.vertices.resize(baseVertex + num_vertices);
+    if (!convertVertices(vertices, num_vertices, translation, textureEntry, &recording.vertices[baseVertex])) {
+        // Too far from the view origin for the quantized positions, drawn relative to its centre instead
+        bool fits;
+        draw.translation = positionOrigin(computeBounds(vertices, num_vertices).translated(translation), fits);
+        if (!fits) recording.stats.clampedGeometry++;
+        convertVertices(vertices, num_vertices, Rocket::Core::Vector2f(translation.x - draw.translation.x, translation.y - draw.translation.y),
+            textureEntry, &recording.vertices[baseVertex]);
+    }
+
+    // Unindexed geometry gets a trivial index list so it can share a batch with everything else
+    const uint32_t segmentOffset = baseVertex - recording.segmentBase;
+    recording.indices.resize(draw.firstIndex + draw.numIndices);
+    uint16_t * outIndices = &recording.indices[draw.firstIndex];
+    for (uint32_t n = 0; n < draw.numIndices; ++n) {
+        outIndices[n] = static_cast<uint16_t>(segmentOffset + (num_indices ? static_cast<uint32_t>(indices[n]) : n));
+    }
+
+    recording.draws.push_back(draw);
 }
-// We store the compiled geometry internally as a tuple, and then reference it based on an int index handle we give back to rocket.
-// Rocket provides INT32 indexes, RBGA8 textures and its vertex data defined in the header. we just compile them up into static buffers and go.
+// Geometry with more vertices than a 16-bit index can address is cut into segments triangle by triangle, duplicating
+// only the vertices shared across a cut.
+void RocketBgfxInterface::appendSplitGeometry(Recorder & recording, const Rocket::Core::Vertex * vertices, int num_vertices, const int * indices, int num_indices,
+    const TextureEntry * texture, Rocket::Core::TextureHandle textureHandle, const Rocket::Core::Vector2f & translation)
+{
+    const uint32_t numIndices = static_cast<uint32_t>(num_indices ? num_indices : num_vertices);
+    std::vector<int32_t> remap(num_vertices, -1);
+    std::vector<uint32_t> remapped;
+
+    DrawRecord draw;
+    draw.vertexBuffer = BGFX_INVALID_HANDLE;
+    draw.indexBuffer = BGFX_INVALID_HANDLE;
+    draw.texture = drawTexture(texture, draw.lateTexture, textureHandle);
+    draw.numVertices = 0;
+    draw.numIndices = 0;
+    draw.scissor = recording.scissor;
+    draw.lateGeometry = 0;
+
+    // Every segment is drawn relative to the same origin, see positionOrigin()
+    bool fits;
+    draw.translation = positionOrigin(computeBounds(vertices, num_vertices).translated(translation), fits);
+    if (!fits) recording.stats.clampedGeometry++;
+    const Rocket::Core::Vector2f offset(translation.x - draw.translation.x, translation.y - draw.translation.y);
+
+    for (uint32_t n = 0; n + 2 < numIndices; n += 3) {
+        if (draw.numIndices == 0 || recording.vertices.size() + 3 - recording.segmentBase > MAX_SEGMENT_VERTICES) {
+            if (draw.numIndices) {
+                recording.draws.push_back(draw);
+            }
+            for (auto vertex : remapped) remap[vertex] = -1;
+            remapped.clear();
+
+            recording.segmentBase = static_cast<uint32_t>(recording.vertices.size());
+            draw.firstVertex = recording.segmentBase;
+            draw.firstIndex = static_cast<uint32_t>(recording.indices.size());
+            draw.numIndices = 0;
+        }
+
+        for (uint32_t corner = 0; corner < 3; ++corner) {
+            const uint32_t vertex = num_indices ? static_cast<uint32_t>(indices[n + corner]) : n + corner;
+            if (remap[vertex] < 0) {
+                remap[vertex] = static_cast<int32_t>(recording.vertices.size() - recording.segmentBase);
+                remapped.push_back(vertex);
+                recording.vertices.emplace_back();
+                convertVertices(&vertices[vertex], 1, offset, texture, &recording.vertices.back());
+            }
+            recording.indices.push_back(static_cast<uint16_t>(remap[vertex]));
+        }
+        draw.numIndices += 3;
+    }
+
+    if (draw.numIndices) {
+        recording.draws.push_back(draw);
+    }
+}
+// We store the compiled geometry internally as a tuple, and then reference it based on the slot map handle we give back to rocket.
+// Rocket provides INT32 indexes, RBGA8 textures and its vertex data defined in the header. We quantize the vertices (remapping
+// the UVs if the texture lives in the atlas), narrow the indices to 16 bits whenever the vertex count allows it, and
+// suballocate them from the shared geometry arenas rather than creating a buffer pair per element.
+// Recording threads hand the upload to frame(), their geometry has no arena allocation until then.
 Rocket::Core::CompiledGeometryHandle RocketBgfxInterface::CompileGeometry(
     Rocket::Core::Vertex* vertices,
     int num_vertices,
     int* indices, int num_indices,
     Rocket::Core::TextureHandle texture)
 {
-    int returnIndex = _currentGeometryIndex;
-    if (returnIndex < 1)
-        returnIndex = 1;
+    Recorder & recording = recorder();
+    RocketBgfxScopedTimer timer(recording.stats.compileGeometryNs, _trace, "RocketBgfxInterface::CompileGeometry");
+    recording.stats.compileGeometryCalls++;
 
-    bgfx::VertexBufferHandle vertexBuffer{ bgfx::invalidHandle };
-    bgfx::IndexBufferHandle indexBuffer{ bgfx::invalidHandle };
-    bgfx::TextureHandle _texture{ bgfx::invalidHandle };
+    if (num_vertices < 1)
+        return 0;
 
-    if (num_indices) {
-        indexBuffer = bgfx::createIndexBuffer(bgfx::copy(indices, num_indices * sizeof(int32_t)), BGFX_BUFFER_INDEX32);
+    // The same input compiles to the same output, so a hit skips the conversion as well as the upload. Rocket's input
+    // is gone once this returns, so it can't be compared: a hit is the same hash, texture included, and the same vertex
+    // and index counts. Two different inputs of the same size colliding in 64 bits is a risk taken on purpose.
+    const uint64_t hash = RocketBgfxSimd::hash(indices, size_t(num_indices) * sizeof(int),
+        RocketBgfxSimd::hash(vertices, size_t(num_vertices) * sizeof(Rocket::Core::Vertex), static_cast<uint64_t>(texture)));
+    {
+        TableWriteLock tables = writeTables();
+        auto range = _geometryByHash.equal_range(hash);
+        auto cached = std::find_if(range.first, range.second, [&](const std::pair<const uint64_t, uint32_t> & key) {
+            const CompiledGeometry * existing = _geometry.find(key.second);
+            return existing->numVertices == uint32_t(num_vertices) && existing->numIndices == uint32_t(num_indices);
+        });
+        if (cached != range.second) {
+            CompiledGeometry * existing = _geometry.find(cached->second);
+            existing->refCount++;
+            _geometryCacheStats.hits++;
+            _geometryCacheStats.bytesSaved += existing->bytes;
+
+            if (_capture) _capture->compileGeometry(cached->second, vertices, num_vertices, indices, num_indices, texture);
+            return static_cast<Rocket::Core::CompiledGeometryHandle>(cached->second);
+        }
     }
 
-    vertexBuffer = bgfx::createVertexBuffer(
-        bgfx::copy(vertices, num_vertices * sizeof(Rocket::Core::Vertex)),
-        RocketVertexData::ms_decl);
+    bool textured;
+    const Bounds bounds = computeBounds(vertices, num_vertices);
+    bool fits;
+    const Rocket::Core::Vector2f origin = positionOrigin(bounds, fits);
+    if (!fits) recording.stats.clampedGeometry++;
+    {
+        TableReadLock tables = readTables();
+        const TextureEntry * textureEntry = findTexture(texture);
+        textured = textureEntry != nullptr;
 
-    if (texture) {
-        _texture = _textureBuffers[texture];
+        // Elements further from their own origin than the positions reach, e.g. the content of a long scroll container,
+        // are stored relative to their centre and drawn that much further along
+        recording.compileVertices.resize(num_vertices);
+        convertVertices(vertices, num_vertices, Rocket::Core::Vector2f(-origin.x, -origin.y), textureEntry, recording.compileVertices.data());
     }
 
-    _geometry[returnIndex] = std::make_tuple(vertexBuffer, indexBuffer, _texture);
+    // Unindexed geometry gets a trivial index list, like in RenderGeometry.
+    // Too many vertices for 16-bit indices are rare enough to keep Rocket's own 32-bit list.
+    const uint32_t numIndices = static_cast<uint32_t>(num_indices ? num_indices : num_vertices);
+    std::vector<uint32_t> wideIndices;
+    if (static_cast<uint32_t>(num_vertices) <= MAX_SEGMENT_VERTICES) {
+        recording.compileIndices.resize(numIndices);
+        for (uint32_t n = 0; n < numIndices; ++n) {
+            recording.compileIndices[n] = static_cast<uint16_t>(num_indices ? indices[n] : n);
+        }
+    }
+    else {
+        wideIndices.resize(numIndices);
+        for (uint32_t n = 0; n < numIndices; ++n) {
+            wideIndices[n] = num_indices ? static_cast<uint32_t>(indices[n]) : n;
+        }
+    }
+    recording.stats.compiledGeometryCreated++;
+    recording.stats.verticesUploaded += static_cast<uint32_t>(num_vertices);
+    recording.stats.indicesUploaded += numIndices;
+
+    const uint32_t bytes = static_cast<uint32_t>(num_vertices * sizeof(RocketVertexData)
+        + numIndices * (wideIndices.empty() ? sizeof(uint16_t) : sizeof(uint32_t)));
+
+    TableWriteLock tables = writeTables();
+    _geometryCacheStats.misses++;
+    const uint32_t handle = _geometry.insert(CompiledGeometry{ 0, textured ? texture : 0, bounds, 1, hash, uint32_t(num_vertices), uint32_t(num_indices), bytes, origin });
+    _geometryByHash.emplace(hash, handle);
+    RocketBgfxGeometryArena::Handle & allocation = _geometry.find(handle)->allocation;
+    if (deferBgfx()) {
+        PendingGeometry pending;
+        pending.handle = handle;
+        pending.vertices.assign(recording.compileVertices.begin(), recording.compileVertices.begin() + num_vertices);
+        if (wideIndices.empty()) {
+            pending.indices.assign(recording.compileIndices.begin(), recording.compileIndices.begin() + numIndices);
+        }
+        pending.wideIndices = std::move(wideIndices);
+        _deferredWork.geometryCreates.push_back(std::move(pending));
+    }
+    else if (wideIndices.empty()) {
+        allocation = _compiledGeometry.allocate(recording.compileVertices.data(), static_cast<uint32_t>(num_vertices), recording.compileIndices.data(), numIndices);
+    }
+    else {
+        allocation = _compiledGeometry.allocate(recording.compileVertices.data(), static_cast<uint32_t>(num_vertices), wideIndices.data(), numIndices, true);
+    }
 
-    _currentGeometryIndex = returnIndex + 1;
-    return static_cast<Rocket::Core::CompiledGeometryHandle>(returnIndex);
+    if (_capture) _capture->compileGeometry(handle, vertices, num_vertices, indices, num_indices, texture);
+    return static_cast<Rocket::Core::CompiledGeometryHandle>(handle);
 }
 
+// Compiled geometry is queued alongside the dynamic geometry so frame() can submit both in painter's order.
+// Geometry whose upload is still deferred is looked up again at submit, as is all of it when recording is decoupled:
+// the bgfx thread may compact the arena before it draws what is recorded now.
 void RocketBgfxInterface::RenderCompiledGeometry(
     Rocket::Core::CompiledGeometryHandle geometry,
     const Rocket::Core::Vector2f& translation)
 {
-    int requestedIndex = static_cast<int>(geometry);
+    if (_capture) _capture->renderCompiledGeometry(geometry, translation);
 
-    bgfx::VertexBufferHandle vertexBuffer;
-    bgfx::IndexBufferHandle indexBuffer;
-    bgfx::TextureHandle texture;
-
-    bgfx::ProgramHandle shader = _colorShader;
+    Recorder & recording = recorder();
+    TableReadLock tables = readTables();
+    const CompiledGeometry * compiled = _geometry.find(static_cast<uint32_t>(geometry));
+    if (!compiled)
+        return;
 
-    float translationMatrix[16] = { 0 };
-    bx::mtxTranslate(translationMatrix, translation.x, translation.y, 0.0f);
-    bgfx::setTransform(translationMatrix);
+    DrawRecord draw;
+    const RocketBgfxGeometryArena::Handle allocation = compiled->allocation;
+    const Rocket::Core::TextureHandle texture = compiled->texture;
 
-    std::tie(vertexBuffer, indexBuffer, texture) = _geometry[requestedIndex];
-    if (bgfx::isValid(texture)) {
-        bgfx::UniformHandle s_texture0 = bgfx::createUniform("s_texture0", bgfx::UniformType::Uniform1iv);
-        bgfx::setTexture(0, s_texture0, texture);
-        shader = _textureShader;
+    if (culls(recording, compiled->bounds.translated(translation))) {
+        recording.culledDraws++;
+        return;
     }
 
-    bgfx::setVertexBuffer(vertexBuffer);
-    if (bgfx::isValid(indexBuffer)) {
-        bgfx::setIndexBuffer(indexBuffer);
+    draw.lateGeometry = 0;
+    if (allocation && !_decoupled) {
+        RocketBgfxGeometryArena::Range range;
+        if (!_compiledGeometry.resolve(allocation, range))
+            return;
+
+        draw.vertexBuffer = range.vertexBuffer;
+        draw.indexBuffer = range.indexBuffer;
+        draw.firstVertex = range.firstVertex;
+        draw.numVertices = range.numVertices;
+        draw.firstIndex = range.firstIndex;
+        draw.numIndices = range.numIndices;
+    }
+    else {
+        draw.vertexBuffer = BGFX_INVALID_HANDLE;
+        draw.indexBuffer = BGFX_INVALID_HANDLE;
+        draw.lateGeometry = static_cast<uint32_t>(geometry);
     }
-    
-    bgfx::setProgram(shader);
-    bgfx::setState(BGFX_STATE_RGB_WRITE
-        | BGFX_STATE_ALPHA_WRITE
-        | BGFX_STATE_MSAA
-        | BGFX_STATE_BLEND_NORMAL);
-    bgfx::submit(_viewNumber);
+
+    const TextureEntry * textureEntry = findTexture(texture);
+    draw.texture = drawTexture(textureEntry, draw.lateTexture, texture);
+    draw.translation = Rocket::Core::Vector2f(translation.x + compiled->origin.x, translation.y + compiled->origin.y);
+    draw.scissor = recording.scissor;
+    signLayerDraw(recording, geometry, texture, textureEntry, translation);
+
+    recording.draws.push_back(draw);
 }
+// The arena holds on to the range until the GPU is done with it. Recording threads may still have draws of it queued,
+// so with threaded recording it is only released once those are submitted. Shared geometry goes with its last release,
+// its content key right away so that no CompileGeometry finds it in between.
 void RocketBgfxInterface::ReleaseCompiledGeometry(Rocket::Core::CompiledGeometryHandle geometry) {
-    bgfx::VertexBufferHandle vertexBuffer;
-    bgfx::IndexBufferHandle indexBuffer;
-    bgfx::TextureHandle texture;
+    if (_capture) _capture->releaseCompiledGeometry(geometry);
 
-    int requestedIndex = static_cast<int>(geometry);
+    Recorder & recording = recorder();
+    TableWriteLock tables = writeTables();
+    const uint32_t handle = static_cast<uint32_t>(geometry);
+    CompiledGeometry * compiled = _geometry.find(handle);
+    if (!compiled || --compiled->refCount > 0)
+        return;
 
-    std::tie(vertexBuffer, indexBuffer, texture) = _geometry[requestedIndex];
-    bgfx::destroyVertexBuffer(vertexBuffer);
-    bgfx::destroyIndexBuffer(indexBuffer);
+    auto range = _geometryByHash.equal_range(compiled->contentHash);
+    for (auto key = range.first; key != range.second; ++key) {
+        if (key->second == handle) {
+            _geometryByHash.erase(key);
+            break;
+        }
+    }
 
-    _geometry.erase(requestedIndex);
+    // Draws queued earlier this frame still refer to its range
+    recording.stats.compiledGeometryReleased++;
+    _deferredWork.geometryReleases.push_back(handle);
 }
 
 // Rocket does a call to scissor enable and THEN calls the scissor region sizing. This is backwards to bgfx as we just call 0/value to scissor, but inline with openGL.
-// So we have to internally track our scissor states of enabled/disabled and the values seperately, and re-set the bgfx scissor value every call.
+// So we have to internally track our scissor states of enabled/disabled and the values seperately. Nothing is set on
+// the view here: the state is captured into each queued draw and applied per draw in frame().
 void RocketBgfxInterface::EnableScissorRegion(bool enable) {
-    _scissorParams.enabled = enable;
-
-    if (_scissorParams.enabled && (_scissorParams.x > 0 || _scissorParams.y > 0 || _scissorParams.width > 0 || _scissorParams.height > 0)) {
-        bgfx::setViewScissor(_viewNumber, _scissorParams.x, _scissorParams.y, _scissorParams.width, _scissorParams.height);
-    }
-    else {
-        bgfx::setViewScissor(_viewNumber, 0, 0, 0, 0);
-    }
-    return;
+    if (_capture) _capture->enableScissorRegion(enable);
+    recorder().scissor.enabled = enable;
 }
 void RocketBgfxInterface::SetScissorRegion(int x, int y, int w, int h) {
-    _scissorParams = { _scissorParams.enabled,
-        static_cast<uint16_t>(x),
-        static_cast<uint16_t>(y),
-        static_cast<uint16_t>(w) ,
-        static_cast<uint16_t>(h) };
-
+    if (_capture) _capture->setScissorRegion(x, y, w, h);
+    // Intersect the region with what 16 bits address: an edge clamped off shrinks the size with it, so the region never
+    // grows. Nothing left of it still clips, at the far corner, as an all-zero region would mean no clipping.
+    const int64_t left = std::min<int64_t>(std::max<int64_t>(x, 0), UINT16_MAX);
+    const int64_t top = std::min<int64_t>(std::max<int64_t>(y, 0), UINT16_MAX);
+    const int64_t right = std::min<int64_t>(std::max<int64_t>(int64_t(x) + std::max(w, 0), left), UINT16_MAX);
+    const int64_t bottom = std::min<int64_t>(std::max<int64_t>(int64_t(y) + std::max(h, 0), top), UINT16_MAX);
+    const bool clippedAway = w > 0 && h > 0 && (right == left || bottom == top);
+    viewScissor_t & scissor = recorder().scissor;
+    scissor = { scissor.enabled,
+        static_cast<uint16_t>(clippedAway ? UINT16_MAX : left),
+        static_cast<uint16_t>(clippedAway ? UINT16_MAX : top),
+        static_cast<uint16_t>(clippedAway ? 0 : right - left),
+        static_cast<uint16_t>(clippedAway ? 0 : bottom - top) };
+}
+bool RocketBgfxInterface::startCapture(const std::string & path) {
+    _capture.reset(new RocketBgfxCaptureWriter(path));
+    if (!_capture->isOpen()) {
+        _capture.reset();
+        return false;
+    }
+    return true;
+}
+void RocketBgfxInterface::setTextureLoaderThreads(unsigned threads) {
+    if (threads == _textureLoaderThreads)
+        return;
 
-    if (_scissorParams.enabled) {
-        bgfx::setViewScissor(_viewNumber, _scissorParams.x, _scissorParams.y, _scissorParams.width, _scissorParams.height);
+    // Finish what the old pool was working on, every pending texture still expects its image. The upload cap doesn't
+    // apply, with a cap of 0 it would never finish.
+    TableWriteLock tables = writeTables();
+    if (_textureLoader) {
+        while (_textureLoader->pending()) {
+            finishTextureLoads(true);
+            std::this_thread::yield();
+        }
+        _textureLoader.reset();
+    }
+    _textureLoaderThreads = threads;
+}
+void RocketBgfxInterface::reportTextureLoadFailure(const Rocket::Core::String & source, const std::string & reason) {
+    if (_textureLoadFailed) {
+        _textureLoadFailed(source, reason);
     }
     else {
-        bgfx::setViewScissor(_viewNumber, 0, 0, 0, 0);
+        std::cerr << "RocketBgfxInterface::LoadTexture() - " << reason << ": " << source.CString() << std::endl;
+    }
+}
+bgfx::TextureHandle RocketBgfxInterface::placeholderTexture() {
+    if (!bgfx::isValid(_placeholderTexture)) {
+        const uint32_t transparent = 0;
+        _placeholderTexture = bgfx::createTexture2D(1, 1, 1, bgfx::TextureFormat::RGBA8,
+            (BGFX_TEXTURE_U_CLAMP | BGFX_TEXTURE_V_CLAMP) | (BGFX_TEXTURE_MIN_POINT | BGFX_TEXTURE_MAG_POINT),
+            bgfx::copy(&transparent, sizeof(transparent)));
+        _frameStats.bytesCopied += sizeof(transparent);
     }
+    return _placeholderTexture;
 }
+// Only the image header is read here: Rocket needs the dimensions straight away to lay the document out. The pixels
+// are decoded on the loader threads while the handle is backed by a reserved atlas region, or by the shared
+// placeholder, and frame() swaps them in. With no loader threads the image is decoded right here as before.
+// Images that can't be loaded are reported through the failure callback and the load fails.
 bool RocketBgfxInterface::LoadTexture(Rocket::Core::TextureHandle& texture_handle, Rocket::Core::Vector2i& texture_dimensions, const Rocket::Core::String& source) {
-    // We load a texture from a file into a buffer, pass it to GenerateTexture
-    // Load the image and get a pointer to the pixels in memory
+    TableWriteLock tables = writeTables();
+    RocketBgfxScopedTimer timer(_textureLoadStats.loadNs, _trace, "RocketBgfxInterface::LoadTexture");
+    const bool loaded = loadTexture(texture_handle, texture_dimensions, source);
+    if (loaded && _capture) _capture->loadTexture(texture_handle, texture_dimensions, source);
+    return loaded;
+}
+bool RocketBgfxInterface::loadTexture(Rocket::Core::TextureHandle& texture_handle, Rocket::Core::Vector2i& texture_dimensions, const Rocket::Core::String& source) {
+    const std::string path = source.CString();
+    auto cached = _texturesBySource.find(path);
+    if (cached != _texturesBySource.end()) {
+        TextureEntry * entry = _textureBuffers.find(cached->second);
+        if (entry) {
+            entry->refCount++;
+            _textureCacheStats.hits++;
+            _textureCacheStats.bytesSaved += uint64_t(entry->width) * entry->height * sizeof(uint32_t);
+
+            texture_handle = static_cast<Rocket::Core::TextureHandle>(cached->second);
+            texture_dimensions = Rocket::Core::Vector2i(entry->width, entry->height);
+            return true;
+        }
+    }
+
+    if (_assetBundle) {
+        const RocketBgfxBundle::Asset * asset = _assetBundle->find(path);
+        if (asset && (asset->kind == RocketBgfxBundle::Kind::Image || RocketBgfxTextureContainer::isContainerPath(path)))
+            return loadFromBundle(texture_handle, texture_dimensions, source, *asset);
+    }
+
+    if (RocketBgfxTextureContainer::isContainerPath(path))
+        return loadContainer(texture_handle, texture_dimensions, source);
+
     int w = 0, h = 0, channels = 0;
-    unsigned char* ptr = stbi_load(source.CString(), &w, &h, &channels, STBI_rgb_alpha);
 
-    // Throw error if the texture file didnt open and ready correctly
-    if (!(ptr && w && h)) {
-        throw std::runtime_error("RocketBgfxInterface::LoadTexture() - FAILED_TO_LOAD_IMAGE_FROM_FILE");
+    if (_textureLoaderThreads == 0) {
+        // Load the image and get a pointer to the pixels in memory
+        unsigned char* ptr = stbi_load(source.CString(), &w, &h, &channels, STBI_rgb_alpha);
+        if (!(ptr && w && h)) {
+            const char * reason = stbi_failure_reason();
+            reportTextureLoadFailure(source, reason ? reason : "FAILED_TO_LOAD_IMAGE_FROM_FILE");
+            RocketBgfxTextureLoader::freePixels(ptr);
+            return false;
+        }
+
+        // Hand it off to the internal texture manager and then deallocate. That may find the same pixels under
+        // another name; the entry keeps the first name it was loaded by.
+        bool ret = generateTexture(texture_handle, ptr, Rocket::Core::Vector2i(w, h), /*generated*/ false);
+        RocketBgfxTextureLoader::freePixels(ptr);
+        _textureLoadStats.imageLoads++;
+
+        TextureEntry * entry = _textureBuffers.find(static_cast<uint32_t>(texture_handle));
+        if (ret && entry && entry->source.empty()) {
+            entry->source = path;
+            _texturesBySource[path] = static_cast<uint32_t>(texture_handle);
+        }
+
+        texture_dimensions = Rocket::Core::Vector2i(w, h);
+        return ret;
     }
 
-    / Hand it off to the internal texture manager and then deallocate
-    bool ret = GenerateTexture(texture_handle, ptr, Rocket::Core::Vector2i(w, h));
-    free(ptr);
+    if (!stbi_info(source.CString(), &w, &h, &channels) || w < 1 || h < 1) {
+        const char * reason = stbi_failure_reason();
+        reportTextureLoadFailure(source, reason ? reason : "FAILED_TO_LOAD_IMAGE_FROM_FILE");
+        return false;
+    }
 
-    return ret;
-}
-bool RocketBgfxInterface::GenerateTexture(Rocket::Core::TextureHandle& texture_handle, const Rocket::Core::byte* source, const Rocket::Core::Vector2i& source_dimensions) {
-    int returnIndex = _currentTextureIndex;
+    if (!_textureLoader) {
+        _textureLoader.reset(new RocketBgfxTextureLoader(_textureLoaderThreads));
+    }
+
+    // Recording threads can't create atlas pages, their images always get their own texture
+    TextureEntry entry;
+    entry.atlased = !deferBgfx()
+        && _textureAtlasEnabled
+        && _textureAtlas.fits(w, h)
+        && _textureAtlas.allocate(static_cast<uint16_t>(w), static_cast<uint16_t>(h), nullptr, entry.region);
+    entry.handle = entry.atlased ? entry.region.texture : placeholderTexture();
+    entry.loadTicket = _textureLoader->request(path);
+    entry.width = static_cast<uint16_t>(w);
+    entry.height = static_cast<uint16_t>(h);
+    entry.refCount = 1;
+    entry.source = path;
+    entry.contentHash = 0;
+    entry.hashed = false;
+    entry.bytes = 0;
+    entry.storage = TextureStorage::Rgba;
+    entry.lastDrawn = _textureFrame;
+    entry.evicted = false;
+    entry.sharedWith = 0;
+
+    const uint32_t handle = _textureBuffers.insert(entry);
+    _pendingTextures[entry.loadTicket] = handle;
+    _texturesBySource[path] = handle;
+    _textureCacheStats.misses++;
+    _textureLoadStats.imageLoads++;
+    recorder().stats.texturesCreated++;
 
+    texture_handle = static_cast<Rocket::Core::TextureHandle>(handle);
+    texture_dimensions = Rocket::Core::Vector2i(w, h);
+    return true;
+}
+// Without pixels the texture is created empty, for uploadTextureRows() to fill
+void RocketBgfxInterface::createTexture(const Rocket::Core::byte * source, int width, int height, TextureEntry & entry) {
     // Create the new texture handle
-    const bgfx::Memory *sourceMemory = bgfx::copy(source, source_dimensions.x * source_dimensions.y * sizeof(uint32_t));
-    //const bgfx::Memory *sourceMemory = bgfx::makeRef(source, source_dimensions.x * source_dimensions.y * sizeof(uint32_t));
-    bgfx::TextureHandle texHandle = bgfx::createTexture2D(source_dimensions.x, source_dimensions.y,
+    const bgfx::Memory *sourceMemory = source ? bgfx::copy(source, width * height * sizeof(uint32_t)) : nullptr;
+    entry.handle = bgfx::createTexture2D(width, height,
         1, bgfx::TextureFormat::RGBA8,
         (BGFX_TEXTURE_U_CLAMP | BGFX_TEXTURE_V_CLAMP) | (BGFX_TEXTURE_MIN_POINT | BGFX_TEXTURE_MAG_POINT),
         sourceMemory);
+    entry.bytes = width * height * sizeof(uint32_t);
+    _textureLoadStats.textureBytes += entry.bytes;
+    if (sourceMemory) {
+        _frameStats.bytesCopied += sourceMemory->size;
+        _textureUploadBytes += sourceMemory->size;
+    }
+}
+// Alpha pages are sampled like RGBA8 ones. Distance fields are sampled bilinearly, that is what reconstructs the edge
+// between texels.
+void RocketBgfxInterface::createSingleChannelTexture(const uint8_t * texels, int width, int height, TextureStorage storage, TextureEntry & entry) {
+    const bgfx::Memory * texelMemory = texels ? bgfx::copy(texels, width * height) : nullptr;
+    entry.handle = bgfx::createTexture2D(width, height, 1, bgfx::TextureFormat::R8,
+        (BGFX_TEXTURE_U_CLAMP | BGFX_TEXTURE_V_CLAMP) | (storage == TextureStorage::Alpha ? BGFX_TEXTURE_MIN_POINT | BGFX_TEXTURE_MAG_POINT : 0),
+        texelMemory);
+    entry.bytes = width * height;
+    _textureLoadStats.textureBytes += entry.bytes;
+    if (texelMemory) {
+        _frameStats.bytesCopied += texelMemory->size;
+        _textureUploadBytes += texelMemory->size;
+    }
+
+    if (_textureStorage.size() <= entry.handle.idx) {
+        _textureStorage.resize(entry.handle.idx + 1, TextureStorage::Rgba);
+    }
+    _textureStorage[entry.handle.idx] = storage;
+}
+// bgfx reuses the index of a destroyed texture, so its storage is forgotten here rather than on release
+void RocketBgfxInterface::destroyTexture(bgfx::TextureHandle texture) {
+    if (texture.idx < _textureStorage.size()) {
+        _textureStorage[texture.idx] = TextureStorage::Rgba;
+    }
+    bgfx::destroyTexture(texture);
+}
+// KTX/DDS files are mapped and handed to bgfx untouched: no decode and no copy, and the compressed formats and mip
+// chains they carry stay that way on the GPU. Only the header is read here, for the dimensions, so these load
+// synchronously even with loader threads.
+bool RocketBgfxInterface::loadContainer(Rocket::Core::TextureHandle& texture_handle, Rocket::Core::Vector2i& texture_dimensions, const Rocket::Core::String& source) {
+    const std::string path = source.CString();
+    std::unique_ptr<RocketBgfxMappedFile> file;
+    RocketBgfxTextureContainer::Info info;
+    std::string error;
+    if (!openContainer(path, file, info, error)) {
+        reportTextureLoadFailure(source, error);
+        return false;
+    }
+
+    TextureEntry entry;
+    entry.atlased = false;
+    entry.loadTicket = 0;
+    entry.width = info.width;
+    entry.height = info.height;
+    entry.refCount = 1;
+    entry.source = path;
+    entry.contentHash = 0;
+    entry.hashed = false;
+    entry.bytes = 0;
+    entry.storage = TextureStorage::Rgba;
+    entry.lastDrawn = _textureFrame;
+    entry.evicted = false;
+    entry.sharedWith = 0;
+    if (deferBgfx()) {
+        entry.handle = _placeholderTexture;     // until frame() creates it
+    }
+    else {
+        createContainerTexture(std::move(file), info, entry);
+    }
+
+    const uint32_t handle = _textureBuffers.insert(entry);
+    if (deferBgfx()) {
+        _deferredWork.textureCreates.push_back(PendingTexture{ handle, std::vector<Rocket::Core::byte>(), info.width, info.height, std::move(file), info, TextureStorage::Rgba, nullptr });
+    }
+    _texturesBySource[path] = handle;
+    _textureCacheStats.misses++;
+    _textureLoadStats.containerLoads++;
+    const uint32_t rgbaBytes = RocketBgfxTextureContainer::storageSize(bgfx::TextureFormat::RGBA8, info.width, info.height, info.mips);
+    _textureLoadStats.containerBytesSaved += rgbaBytes > info.storageSize ? rgbaBytes - info.storageSize : 0;
+    recorder().stats.texturesCreated++;
+
+    texture_handle = static_cast<Rocket::Core::TextureHandle>(handle);
+    texture_dimensions = Rocket::Core::Vector2i(info.width, info.height);
+    return true;
+}
+// Map a KTX/DDS file and read its header, for a texture the renderer can sample
+bool RocketBgfxInterface::openContainer(const std::string & path, std::unique_ptr<RocketBgfxMappedFile> & file, RocketBgfxTextureContainer::Info & info, std::string & error) {
+    file.reset(new RocketBgfxMappedFile());
+    if (!file->open(path)) {
+        error = "FAILED_TO_MAP_FILE";
+        return false;
+    }
+    if (!RocketBgfxTextureContainer::parse(file->data(), file->size(), info, error))
+        return false;
+    if (!bgfx::getCaps()->formats[info.format]) {
+        error = "TEXTURE_FORMAT_NOT_SUPPORTED";
+        return false;
+    }
+    return true;
+}
+// bgfx parses the container itself and reads the texels straight out of the mapping, which is unmapped once bgfx is
+// done with it. The mips are sampled linearly, unlike the pixel exact RGBA8 images.
+void RocketBgfxInterface::createContainerTexture(std::unique_ptr<RocketBgfxMappedFile> file, const RocketBgfxTextureContainer::Info & info, TextureEntry & entry) {
+    RocketBgfxMappedFile * mapping = file.release();
+    _frameStats.bytesReferenced += mapping->size();
+    const bgfx::Memory * memory = bgfx::makeRef(mapping->data(), static_cast<uint32_t>(mapping->size()),
+        [](void *, void * userData) { delete static_cast<RocketBgfxMappedFile *>(userData); }, mapping);
+    entry.handle = bgfx::createTexture(memory, BGFX_TEXTURE_U_CLAMP | BGFX_TEXTURE_V_CLAMP);
+    entry.bytes = info.storageSize;
+    _textureLoadStats.textureBytes += entry.bytes;
+    _textureUploadBytes += entry.bytes;
+}
+// Bundled assets skip the file system, the image decode and the copy: the dimensions come from the index, the content
+// hash was computed by the bundler and bgfx is handed the texels where they are mapped. Small images still go into the
+// atlas, which copies them. Like KTX/DDS files these always load synchronously and go up whole.
+bool RocketBgfxInterface::loadFromBundle(Rocket::Core::TextureHandle& texture_handle, Rocket::Core::Vector2i& texture_dimensions,
+    const Rocket::Core::String& source, const RocketBgfxBundle::Asset & asset)
+{
+    const std::string path = source.CString();
+    const bool image = asset.kind == RocketBgfxBundle::Kind::Image;
+    RocketBgfxTextureContainer::Info info;
+    if (image) {
+        // The same pixels under another name, or generated, are shared like generateTexture() shares them
+        auto range = _texturesByHash.equal_range(asset.contentHash);
+        for (auto cached = range.first; cached != range.second; ++cached) {
+            TextureEntry * existing = _textureBuffers.find(cached->second);
+            if (existing && existing->width == asset.width && existing->height == asset.height) {
+                existing->refCount++;
+                _textureCacheStats.hits++;
+                _textureCacheStats.bytesSaved += asset.size;
+                if (existing->source.empty()) {
+                    existing->source = path;
+                    _texturesBySource[path] = cached->second;
+                }
+
+                texture_handle = static_cast<Rocket::Core::TextureHandle>(cached->second);
+                texture_dimensions = Rocket::Core::Vector2i(asset.width, asset.height);
+                return true;
+            }
+        }
+    }
+    else {
+        std::string error;
+        if (!RocketBgfxTextureContainer::parse(asset.data, asset.size, info, error)) {
+            reportTextureLoadFailure(source, error);
+            return false;
+        }
+        if (!bgfx::getCaps()->formats[info.format]) {
+            reportTextureLoadFailure(source, "TEXTURE_FORMAT_NOT_SUPPORTED");
+            return false;
+        }
+    }
+
+    TextureEntry entry;
+    entry.loadTicket = 0;
+    entry.width = image ? asset.width : info.width;
+    entry.height = image ? asset.height : info.height;
+    entry.refCount = 1;
+    entry.source = path;
+    entry.contentHash = 0;
+    entry.hashed = false;
+    entry.bytes = 0;
+    entry.storage = TextureStorage::Rgba;
+    entry.lastDrawn = _textureFrame;
+    entry.evicted = false;
+    entry.sharedWith = 0;
+    entry.atlased = image
+        && !deferBgfx()
+        && _textureAtlasEnabled
+        && _textureAtlas.fits(asset.width, asset.height)
+        && _textureAtlas.allocate(asset.width, asset.height, asset.data, entry.region);
+    if (entry.atlased) {
+        entry.handle = entry.region.texture;
+    }
+    else if (deferBgfx()) {
+        entry.handle = _placeholderTexture;     // until frame() creates it
+    }
+    else {
+        createBundleTexture(asset, entry);
+    }
+
+    const uint32_t handle = _textureBuffers.insert(entry);
+    if (image) {
+        registerTextureHash(handle, *_textureBuffers.find(handle), asset.contentHash);
+    }
+    if (deferBgfx()) {
+        _deferredWork.textureCreates.push_back(PendingTexture{ handle, std::vector<Rocket::Core::byte>(), entry.width, entry.height, nullptr, info,
+            TextureStorage::Rgba, &asset });
+    }
+    _texturesBySource[path] = handle;
+    _textureCacheStats.misses++;
+    _textureLoadStats.bundleLoads++;
+    if (!image) {
+        const uint32_t rgbaBytes = RocketBgfxTextureContainer::storageSize(bgfx::TextureFormat::RGBA8, info.width, info.height, info.mips);
+        _textureLoadStats.containerBytesSaved += rgbaBytes > info.storageSize ? rgbaBytes - info.storageSize : 0;
+    }
+    RocketBgfxFrameStats & stats = recorder().stats;
+    stats.texturesCreated++;
+    if (image) stats.textureBytes += asset.size;
+
+    texture_handle = static_cast<Rocket::Core::TextureHandle>(handle);
+    texture_dimensions = Rocket::Core::Vector2i(entry.width, entry.height);
+    return true;
+}
+// Images are RGBA8 texels sampled pixel exact like decoded ones, KTX/DDS files are parsed by bgfx like mapped ones
+void RocketBgfxInterface::createBundleTexture(const RocketBgfxBundle::Asset & asset, TextureEntry & entry) {
+    const bgfx::Memory * memory = bgfx::makeRef(asset.data, static_cast<uint32_t>(asset.size));
+    if (asset.kind == RocketBgfxBundle::Kind::Image) {
+        entry.handle = bgfx::createTexture2D(asset.width, asset.height, 1, bgfx::TextureFormat::RGBA8,
+            (BGFX_TEXTURE_U_CLAMP | BGFX_TEXTURE_V_CLAMP) | (BGFX_TEXTURE_MIN_POINT | BGFX_TEXTURE_MAG_POINT), memory);
+        entry.bytes = static_cast<uint32_t>(asset.size);
+    }
+    else {
+        RocketBgfxTextureContainer::Info info;
+        std::string error;
+        RocketBgfxTextureContainer::parse(asset.data, asset.size, info, error);     // validated when it was loaded
+        entry.handle = bgfx::createTexture(memory, BGFX_TEXTURE_U_CLAMP | BGFX_TEXTURE_V_CLAMP);
+        entry.bytes = info.storageSize;
+    }
+    _frameStats.bytesReferenced += asset.size;
+    _textureLoadStats.textureBytes += entry.bytes;
+    _textureUploadBytes += entry.bytes;
+}
+void RocketBgfxInterface::registerTextureHash(uint32_t texture, TextureEntry & entry, uint64_t hash) {
+    entry.contentHash = hash;
+    entry.hashed = true;
+    _texturesByHash.emplace(hash, texture);
+}
+// A texture of its own with these RGBA pixels that a decoded image can share: not an atlas region, and not one whose
+// own pixels are still decoding. 0 when there is none.
+uint32_t RocketBgfxInterface::findLoadedTexture(uint64_t hash, int width, int height) const {
+    auto range = _texturesByHash.equal_range(hash);
+    for (auto cached = range.first; cached != range.second; ++cached) {
+        const TextureEntry * existing = _textureBuffers.find(cached->second);
+        if (existing && existing->width == width && existing->height == height
+            && !existing->atlased && !existing->loadTicket && existing->storage == TextureStorage::Rgba) {
+            return cached->second;
+        }
+    }
+    return 0;
+}
+// Drop the entry from the cache indices so no later load or generate can return it
+void RocketBgfxInterface::forgetTextureKeys(uint32_t texture, TextureEntry & entry) {
+    if (!entry.source.empty()) {
+        auto bySource = _texturesBySource.find(entry.source);
+        if (bySource != _texturesBySource.end() && bySource->second == texture) {
+            _texturesBySource.erase(bySource);
+        }
+        entry.source.clear();
+    }
+    if (entry.hashed) {
+        auto range = _texturesByHash.equal_range(entry.contentHash);
+        for (auto byHash = range.first; byHash != range.second; ++byHash) {
+            if (byHash->second == texture) {
+                _texturesByHash.erase(byHash);
+                break;
+            }
+        }
+        entry.hashed = false;
+    }
+}
+// Small images are packed into the shared atlas so they can batch with each other, anything else gets its own texture.
+// Pixels identical to a live texture of the same size reuse it; the 64-bit hash is trusted without comparing the pixels,
+// which are no longer around once uploaded.
+bool RocketBgfxInterface::GenerateTexture(Rocket::Core::TextureHandle& texture_handle, const Rocket::Core::byte* source, const Rocket::Core::Vector2i& source_dimensions) {
+    TableWriteLock tables = writeTables();
+    const bool generated = generateTexture(texture_handle, source, source_dimensions);
+    if (generated && _capture) _capture->generateTexture(texture_handle, source, source_dimensions);
+    return generated;
+}
+bool RocketBgfxInterface::generateTexture(Rocket::Core::TextureHandle& texture_handle, const Rocket::Core::byte* source, const Rocket::Core::Vector2i& source_dimensions,
+    bool generated)
+{
+    const size_t bytes = size_t(source_dimensions.x) * source_dimensions.y * sizeof(uint32_t);
+    const uint64_t hash = RocketBgfxSimd::hash(source, bytes);
+
+    auto range = _texturesByHash.equal_range(hash);
+    for (auto cached = range.first; cached != range.second; ++cached) {
+        TextureEntry * existing = _textureBuffers.find(cached->second);
+        if (existing && existing->width == source_dimensions.x && existing->height == source_dimensions.y
+            && (generated || existing->storage == TextureStorage::Rgba)) {
+            existing->refCount++;
+            _textureCacheStats.hits++;
+            _textureCacheStats.bytesSaved += bytes;
+
+            texture_handle = static_cast<Rocket::Core::TextureHandle>(cached->second);
+            return true;
+        }
+    }
+
+    // White pages, libRocket's glyph pages, only need their alpha when there is a program to draw them. They are
+    // converted right here, which puts the work on the recording thread. Images LoadTexture decoded are not glyph
+    // pages even when they are white, and always stay RGBA.
+    const size_t texels = size_t(source_dimensions.x) * source_dimensions.y;
+    TextureStorage storage = TextureStorage::Rgba;
+    std::vector<uint8_t> singleChannel;
+    if (generated && (bgfx::isValid(_distanceFieldShader) || bgfx::isValid(_alphaShader)) && RocketBgfxSimd::isWhite(source, texels)) {
+        if (bgfx::isValid(_distanceFieldShader)) {
+            storage = TextureStorage::DistanceField;
+            RocketBgfxDistanceField::generate(source, source_dimensions.x, source_dimensions.y, singleChannel);
+            _textureLoadStats.distanceFieldPages++;
+        }
+        else {
+            storage = TextureStorage::Alpha;
+            singleChannel.resize(texels);
+            RocketBgfxSimd::extractAlpha(source, texels, singleChannel.data());
+            _textureLoadStats.alphaPages++;
+        }
+        _textureLoadStats.singleChannelBytesSaved += bytes - texels;
+    }
+
+    TextureEntry entry;
+    entry.loadTicket = 0;
+    entry.width = static_cast<uint16_t>(source_dimensions.x);
+    entry.height = static_cast<uint16_t>(source_dimensions.y);
+    entry.refCount = 1;
+    entry.hashed = false;
+    entry.bytes = 0;
+    entry.storage = storage;
+    entry.lastDrawn = _textureFrame;
+    entry.evicted = false;
+    entry.sharedWith = 0;
+    entry.atlased = storage == TextureStorage::Rgba
+        && !deferBgfx()
+        && _textureAtlasEnabled
+        && _textureAtlas.fits(source_dimensions.x, source_dimensions.y)
+        && _textureAtlas.allocate(static_cast<uint16_t>(source_dimensions.x), static_cast<uint16_t>(source_dimensions.y), source, entry.region);
+
+    if (entry.atlased) {
+        entry.handle = entry.region.texture;
+    }
+    else if (deferBgfx()) {
+        entry.handle = _placeholderTexture;     // until frame() creates it
+    }
+    else if (overUploadBudget(storage == TextureStorage::Rgba ? bytes : texels)) {
+        entry.handle = placeholderTexture();    // until frame() has uploaded it
+    }
+    else if (storage != TextureStorage::Rgba) {
+        createSingleChannelTexture(singleChannel.data(), source_dimensions.x, source_dimensions.y, storage, entry);
+    }
+    else {
+        createTexture(source, source_dimensions.x, source_dimensions.y, entry);
+    }
 
     // Save the texture reference
-    _textureBuffers[returnIndex] = texHandle;
+    const uint32_t handle = _textureBuffers.insert(entry);
+    TextureEntry & inserted = *_textureBuffers.find(handle);
+    registerTextureHash(handle, inserted, hash);
+    if (generated && _textureBudget && !entry.atlased) {
+        // What the texture is created again from once the budget has evicted it
+        inserted.retained = storage != TextureStorage::Rgba ? singleChannel : std::vector<uint8_t>(source, source + bytes);
+        _textureResidencyStats.retainedBytes += inserted.retained.size();
+    }
+    if (!entry.atlased && !deferBgfx() && entry.handle.idx == _placeholderTexture.idx) {
+        queueTextureUpload(handle, storage != TextureStorage::Rgba ? std::move(singleChannel) : std::vector<uint8_t>(source, source + bytes),
+            source_dimensions.x, source_dimensions.y, storage);
+    }
+    if (deferBgfx()) {
+        _deferredWork.textureCreates.push_back(PendingTexture{ handle,
+            storage != TextureStorage::Rgba ? std::move(singleChannel) : std::vector<Rocket::Core::byte>(source, source + bytes),
+            source_dimensions.x, source_dimensions.y, nullptr, RocketBgfxTextureContainer::Info(), storage, nullptr });
+    }
+    _textureCacheStats.misses++;
+    RocketBgfxFrameStats & stats = recorder().stats;
+    stats.texturesCreated++;
+    stats.textureBytes += storage == TextureStorage::Rgba ? bytes : texels;
 
-    _currentTextureIndex = _currentTextureIndex + 1;
-    texture_handle = returnIndex;
+    texture_handle = static_cast<Rocket::Core::TextureHandle>(handle);
 
     return true;
 }
 void RocketBgfxInterface::ReleaseTexture(Rocket::Core::TextureHandle texture) {
-    int requestedIndex = static_cast<int>(texture);
+    if (_capture) _capture->releaseTexture(texture);
 
-    if (_textureBuffers.find(requestedIndex) != _textureBuffers.end()) {
-        bgfx::destroyTexture(_textureBuffers[requestedIndex]);  // clear the texture handle
-        _textureBuffers.erase(requestedIndex);
-    }
+    TableWriteLock tables = writeTables();
+    releaseTexture(static_cast<uint32_t>(texture));
+}
+// An entry sharing another's texture gives its reference back once it goes
+void RocketBgfxInterface::releaseTexture(uint32_t texture) {
+    TextureEntry * entry = _textureBuffers.find(texture);
+    if (!entry || --entry->refCount > 0)
+        return;
 
-    return;
-}
\ No newline at end of file
+    forgetTextureKeys(texture, *entry);
+    _textureLoadStats.textureBytes -= entry->bytes;
+    _textureResidencyStats.retainedBytes -= entry->retained.size();
+    if (entry->evicted) _textureResidencyStats.evicted--;
+    // Both wait for the draws queued so far, which still sample them
+    if (entry->atlased) {
+        _deferredWork.atlasReleases.push_back(entry->region);
+    }
+    else if (!entry->sharedWith && entry->handle.idx != _placeholderTexture.idx) {
+        _deferredWork.textureDestroys.push_back(entry->handle);
+    }
+    if (entry->loadTicket) {
+        // Still decoding, frame() drops the image when it arrives
+        _pendingTextures.erase(entry->loadTicket);
+    }
+    const uint32_t shared = entry->sharedWith;
+    _textureBuffers.erase(texture);
+    if (shared) releaseTexture(shared);
+}
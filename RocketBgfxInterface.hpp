@@ -1,29 +1,78 @@
 #pragma once
 
 #include <bgfx.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
 #include <Rocket/Core/RenderInterface.h>
 
+#include "RocketBgfxBundle.hpp"
+#include "RocketBgfxCapture.hpp"
+#include "RocketBgfxDistanceField.hpp"
+#include "RocketBgfxFrameArena.hpp"
+#include "RocketBgfxGeometryArena.hpp"
+#include "RocketBgfxGeometryRing.hpp"
+#include "RocketBgfxMappedFile.hpp"
+#include "RocketBgfxSimd.hpp"
+#include "RocketBgfxSlotMap.hpp"
+#include "RocketBgfxStats.hpp"
+#include "RocketBgfxSubmitter.hpp"
+#include "RocketBgfxTextureAtlas.hpp"
+#include "RocketBgfxTextureContainer.hpp"
+#include "RocketBgfxTextureLoader.hpp"
+
+#include <string>
 #include <unordered_map>
+#include <vector>
+#include <tuple>
 
 class RocketBgfxInterface :
     public Rocket::Core::RenderInterface
 {
-    constexpr static const size_t MAX_DYNAMIC_VERTICES = 4096;
-    constexpr static const size_t MAX_DYNAMIC_INDICES = 4096;
+    // Starting size of each dynamic geometry ring slot, it grows past this on demand
+    constexpr static const uint32_t DEFAULT_DYNAMIC_VERTICES = 4096;
+    constexpr static const uint32_t DEFAULT_DYNAMIC_INDICES = 4096;
+
+    // Vertices one 16-bit index can address; dynamic geometry is cut into segments of at most this size
+    constexpr static const uint32_t MAX_SEGMENT_VERTICES = 65536;
+    // Fixed point steps per pixel of the quantized vertex positions, must match vs_BgfxRocketRenderTest.sc. They reach
+    // MAX_POSITION pixels either way of their draw's origin; geometry reaching further is drawn relative to its own
+    // centre instead, and only geometry more than twice that across is still squashed (see clampedGeometry).
+    constexpr static const int POSITION_SUBPIXELS = 4;
+    constexpr static const float MAX_POSITION = 32767.0f / POSITION_SUBPIXELS;
+    // Bytes of instance data per instanced compiled draw, a vec4 whose xy is the translation. Must match
+    // vs_BgfxRocketRenderTestInstanced.sc
+    constexpr static const uint16_t INSTANCE_STRIDE = 16;
 
+    // Decoded images swapped in per frame() by default, and the decode threads started on the first LoadTexture
+    constexpr static const uint32_t DEFAULT_TEXTURE_UPLOADS_PER_FRAME = 4;
+    constexpr static const unsigned DEFAULT_TEXTURE_LOADER_THREADS = 2;
+    // Texture memory retained layers may hold by default
+    constexpr static const uint64_t DEFAULT_LAYER_BUDGET = 32 * 1024 * 1024;
+    // Largest layer side, bigger ones are drawn directly. Every bgfx renderer supports render targets this size.
+    constexpr static const int MAX_LAYER_SIZE = 4096;
+
+    // Quantized GPU vertex: 12 bytes instead of the 20 of a Rocket::Core::Vertex.
+    // Positions are fixed point with POSITION_SUBPIXELS steps per pixel, relative to the draw origin (the view for
+    // baked dynamic geometry, the element for compiled geometry). UVs are normalized to [0, 32767]. Both are read as
+    // snorm16, which every renderer supports; the vertex shader scales the position back to pixels.
     struct RocketVertexData {
-        float   m_position[2];
+        int16_t m_position[2];
         uint8_t m_color[4];
-        float   m_texCoords[2];
+        int16_t m_texCoords[2];
 
         static void init()
         {
             ms_decl
                 .begin()
-                .add(bgfx::Attrib::Position, 2, bgfx::AttribType::Float)
+                .add(bgfx::Attrib::Position, 2, bgfx::AttribType::Int16, true)
                 .add(bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true)
-                .add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float)
+                .add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Int16, true)
                 .end();
         };
 
@@ -32,34 +81,430 @@ class RocketBgfxInterface :
 
     /// The shader the render interface uses
     bgfx::ProgramHandle _colorShader, _textureShader;
+    // Instanced variants, only set when the renderer supports instancing
+    bgfx::ProgramHandle _colorInstancedShader, _textureInstancedShader;
+    // Draw single-channel textures, see setAlphaShader() and setDistanceFieldShader()
+    bgfx::ProgramHandle _alphaShader, _distanceFieldShader;
+
+    // How a texture stores its texels, which decides the program that draws it
+    enum class TextureStorage : uint8_t {
+        Rgba = 0,           // RGBA8, images and pages with color
+        Alpha,              // R8 alpha of a white page
+        DistanceField,      // R8 distance field of a white page
+    };
 
     // Internal buffer state tracking
     int _viewNumber;
-    int _currentGeometryIndex;
-    int _currentTextureIndex;
-    std::unordered_map<int, std::tuple <bgfx::VertexBufferHandle, 
-                                        bgfx::IndexBufferHandle, 
-                                        bgfx::TextureHandle>> _geometry;
-    std::unordered_map<int, bgfx::TextureHandle>              _textureBuffers;
+    // Axis-aligned bounds of a mesh, in its own coordinate space until translated
+    struct Bounds {
+        float minX, minY, maxX, maxY;
+
+        Bounds translated(const Rocket::Core::Vector2f & t) const noexcept { return { minX + t.x, minY + t.y, maxX + t.x, maxY + t.y }; }
+    };
 
+    // Rocket's geometry and texture handles are slot map handles into these tables. Compiled geometry keeps Rocket's
+    // texture handle rather than the bgfx one, as a texture that is still loading changes its bgfx handle later.
+    // Identical compilations are shared like textures, the entry lives until every CompileGeometry that returned it
+    // is released.
+    struct CompiledGeometry {
+        RocketBgfxGeometryArena::Handle allocation;     // 0 while the upload is deferred to frame()
+        Rocket::Core::TextureHandle     texture;
+        Bounds                          bounds;
+        uint32_t                        refCount;
+        uint64_t                        contentHash;    // key in _geometryByHash
+        uint32_t                        numVertices;    // Rocket's counts, checked along with the hash
+        uint32_t                        numIndices;
+        uint32_t                        bytes;          // GPU memory of its vertices and indices
+        Rocket::Core::Vector2f          origin;         // its vertices are relative to this, see MAX_POSITION
+    };
+    RocketBgfxSlotMap<CompiledGeometry>                       _geometry;
+    std::unordered_multimap<uint64_t, uint32_t>               _geometryByHash;       // Rocket vertices, indices and texture
+    RocketBgfxGeometryArena                                   _compiledGeometry;
 
-    std::vector<std::tuple<
-        const bgfx::Memory *,
-        const bgfx::Memory *,
-        bgfx::TextureHandle,
-        Rocket::Core::Vector2<float>>>                              _batchGeometry;
+    // A Rocket texture: either its own bgfx texture, or a region of a shared atlas page.
+    // Identical textures are shared, the entry lives until every LoadTexture/GenerateTexture that returned it is released.
+    // Textures of their own that can be created again, from their source file or a retained copy of their texels, are
+    // what the texture budget evicts.
+    struct TextureEntry {
+        bgfx::TextureHandle             handle;
+        bool                            atlased;
+        RocketBgfxTextureAtlas::Region  region;     // only valid when atlased
+        uint32_t                        loadTicket; // non-zero while the image is decoding, handle is the placeholder unless atlased
+        uint16_t                        width, height;
+        uint32_t                        refCount;
+        std::string                     source;     // cache key of loaded textures, empty for generated ones
+        uint64_t                        contentHash;
+        bool                            hashed;     // contentHash is known and registered in _texturesByHash
+        uint32_t                        bytes;      // GPU memory of its own texture, 0 for atlas regions and placeholders
+        TextureStorage                  storage;    // how retained holds its texels
+        std::vector<uint8_t>            retained;   // texels of a generated texture, kept while there is a texture budget
+        uint64_t                        lastDrawn;  // texture frame it was last drawn in
+        bool                            evicted;    // handle is the placeholder until frame() creates it again
+        uint32_t                        sharedWith; // entry whose texture it draws, holding a reference on it; 0 if its own
+    };
+    RocketBgfxSlotMap<TextureEntry>                           _textureBuffers;
+    std::unordered_map<std::string, uint32_t>                 _texturesBySource;
+    std::unordered_multimap<uint64_t, uint32_t>               _texturesByHash;
+    RocketBgfxTextureAtlas                                    _textureAtlas;
+    bool                                                      _textureAtlasEnabled;
 
-    bgfx::DynamicVertexBufferHandle                           _dynamicVertexBuffer;
-    bgfx::DynamicIndexBufferHandle                            _dynamicIndexBuffer;
+public:
+    // Compiled geometry cache counters since construction
+    struct GeometryCacheStats {
+        uint32_t hits;              // CompileGeometry calls served by an existing compilation
+        uint32_t misses;            // ... that uploaded new geometry
+        uint64_t bytesSaved;        // GPU memory the hits did not allocate and upload
 
-    float _width;
-    float _height;
+        // Share of the compilations that were duplicates
+        float dedupRatio() const noexcept { return hits + misses ? float(hits) / float(hits + misses) : 0.0f; }
+    };
+    // Texture cache counters since construction
+    struct TextureCacheStats {
+        uint32_t hits;              // LoadTexture/GenerateTexture calls served by an existing texture
+        uint32_t misses;            // ... that created a new texture
+        uint64_t bytesSaved;        // RGBA8 texture memory the hits did not allocate and upload
+    };
+    // Texture loading counters since construction, cache hits aren't loads
+    struct TextureLoadStats {
+        uint32_t alphaPages;        // generated white pages stored as their alpha channel
+        uint32_t distanceFieldPages; // ... as distance fields
+        uint64_t singleChannelBytesSaved; // RGBA8 memory those two kinds of pages did not take
+        uint32_t imageLoads;        // LoadTexture calls decoding an image to RGBA8
+        uint32_t containerLoads;    // ... uploading a KTX/DDS file as it is
+        uint32_t bundleLoads;       // ... handing bgfx an image or KTX/DDS file in the asset bundle, see setAssetBundle()
+        uint64_t containerBytesSaved; // RGBA8 memory with the same mips those formats did not take
+        uint64_t textureBytes;      // GPU memory of the live textures that aren't atlas regions
+        uint64_t loadNs;            // inside LoadTexture, synchronous decodes included
+        uint64_t decodeNs;          // decoding on the loader threads
+    };
+    // Texture residency state, see setTextureBudget() and setTextureUploadBudget()
+    struct TextureResidencyStats {
+        uint32_t evictions;         // textures destroyed to stay within the budget, since construction
+        uint32_t restores;          // ... created again since, to be drawn
+        uint32_t evicted;           // without their GPU texture now
+        uint64_t retainedBytes;     // CPU copies of generated textures kept to restore them from
+        uint32_t deferredUploads;   // textures that went over a frame's upload budget, since construction
+        uint32_t queuedUploads;     // ... still being uploaded
+        uint64_t queuedUploadBytes; // their rows not uploaded yet
+    };
+    typedef std::function<void(const Rocket::Core::String & source, const std::string & reason)> TextureLoadFailedCallback;
+private:
+    // Asynchronous LoadTexture state
+    std::unique_ptr<RocketBgfxTextureLoader>                  _textureLoader;
+    unsigned                                                  _textureLoaderThreads;  // 0 loads synchronously
+    std::unordered_map<uint32_t, uint32_t>                    _pendingTextures;       // loader ticket -> texture handle
+    uint32_t                                                  _textureUploadsPerFrame;
+    bgfx::TextureHandle                                       _placeholderTexture;    // 1x1 transparent, created on demand
+    TextureLoadFailedCallback                                 _textureLoadFailed;
+    TextureCacheStats                                         _textureCacheStats;
+    GeometryCacheStats                                        _geometryCacheStats;
+    TextureLoadStats                                          _textureLoadStats;
+    std::vector<TextureStorage>                               _textureStorage;        // by bgfx texture index
 
+    // Texture residency, see setTextureBudget() and setTextureUploadBudget()
+    struct TextureUpload {
+        uint32_t             handle;
+        bgfx::TextureHandle  texture;       // invalid until the first rows go up
+        std::vector<uint8_t> texels;
+        uint16_t             width, height;
+        uint16_t             nextRow;
+        TextureStorage       storage;
+    };
+    std::deque<TextureUpload>                                 _textureUploads;        // uploaded a band of rows per frame, in order
+    uint64_t                                                  _textureBudget;
+    uint64_t                                                  _textureUploadBudget;
+    uint64_t                                                  _textureUploadBytes;    // since the last frame()
+    uint64_t                                                  _textureFrame;          // frame() calls, for TextureEntry::lastDrawn
+    TextureResidencyStats                                     _textureResidencyStats;
+    const RocketBgfxBundle *                                  _assetBundle;           // not owned
+
+
+    // Rocket's scissor state. It is captured into every queued draw and applied per draw, not per view.
     struct viewScissor_t {
         bool enabled;
         uint16_t x, y, width, height;
+
+        // Rocket enables scissoring before it sets a region, an all-zero region means no clipping yet
+        bool active() const noexcept { return enabled && (x > 0 || y > 0 || width > 0 || height > 0); }
+        bool operator==(const viewScissor_t & other) const noexcept {
+            return active() == other.active() && (!active()
+                || (x == other.x && y == other.y && width == other.width && height == other.height));
+        }
+        bool excludes(const Bounds & bounds) const noexcept {
+            return active() && (bounds.maxX <= x || bounds.maxY <= y || bounds.minX >= x + width || bounds.minY >= y + height);
+        }
+    };
+
+    // A queued draw, replayed in Rocket's painter order by frame(). Dynamic draws index into the frame staging
+    // arrays with their translation already baked in; compiled draws reference their range of a geometry arena.
+    struct DrawRecord {
+        bgfx::DynamicVertexBufferHandle vertexBuffer;   // invalid for dynamic geometry
+        bgfx::DynamicIndexBufferHandle  indexBuffer;
+        bgfx::TextureHandle         texture;
+        uint32_t                    firstVertex;    // arena offset, or segment base for dynamic geometry
+        uint32_t                    numVertices;
+        uint32_t                    firstIndex;
+        uint32_t                    numIndices;
+        Rocket::Core::Vector2f      translation;    // compiled geometry, or dynamic geometry rebased on its centre
+        viewScissor_t               scissor;
+        uint32_t                    lateGeometry;   // compiled geometry looked up at submit instead, else 0
+        uint32_t                    lateTexture;    // texture still backed by the placeholder, looked up again at submit
+
+        bool isDynamic() const noexcept { return !bgfx::isValid(vertexBuffer) && !lateGeometry; }
+        // Compiled draws of the same range, texture and scissor, which may differ only in translation
+        bool repeats(const DrawRecord & draw) const noexcept {
+            return !isDynamic() && !draw.isDynamic()
+                && lateGeometry == draw.lateGeometry
+                && (lateGeometry || (vertexBuffer.idx == draw.vertexBuffer.idx && indexBuffer.idx == draw.indexBuffer.idx
+                    && firstVertex == draw.firstVertex && firstIndex == draw.firstIndex && numIndices == draw.numIndices))
+                && texture.idx == draw.texture.idx
+                && lateTexture == draw.lateTexture
+                && scissor == draw.scissor;
+        }
+    };
+
+    // A stretch of a recorder's draws that belongs to a layer, see beginLayer()
+    struct LayerSpan {
+        uint32_t id;
+        int      x, y, width, height;
+        uint32_t firstDraw, endDraw;
+        uint64_t signature;         // of the rect and everything drawn into it
+    };
+
+    // Everything one thread records between two frame() calls. The API thread records into _mainRecorder, with
+    // threaded recording every other thread gets its own so contexts can render in parallel without sharing staging.
+    struct Recorder {
+        std::vector<DrawRecord>       draws;
+        RocketBgfxFrameArena::Array<RocketVertexData> vertices;   // lent to bgfx as they are, see submitRecorder()
+        RocketBgfxFrameArena::Array<uint16_t>         indices;    // relative to the draw's segment
+        uint32_t                      segmentBase;      // first vertex of the current segment
+        viewScissor_t                 scissor;
+        uint32_t                      culledDraws;      // since the last frame()
+        int                           order;            // frame() submits recorders in ascending order
+        RocketBgfxFrameStats          stats;            // this thread's share of the frame's counters
+        std::vector<RocketVertexData> compileVertices;  // conversion scratch
+        std::vector<uint16_t>         compileIndices;
+        std::vector<LayerSpan>        layers;
+        std::vector<uint32_t>         invalidatedLayers;
+        int                           openLayer;        // index into layers between beginLayer and endLayer, else -1
+
+        explicit Recorder(RocketBgfxFrameArena * arena = nullptr) : vertices(arena), indices(arena), segmentBase(0), scissor({ false, 0, 0, 0, 0 }), culledDraws(0), order(0), stats(), openLayer(-1) {}
+
+        void clearDraws() {
+            draws.clear();
+            vertices.clear();
+            indices.clear();
+            segmentBase = 0;
+            layers.clear();
+            invalidatedLayers.clear();
+            openLayer = -1;
+        }
+        // Empty layers are dropped
+        void closeLayer() {
+            if (openLayer < 0)
+                return;
+            layers[openLayer].endDraw = static_cast<uint32_t>(draws.size());
+            if (layers[openLayer].endDraw == layers[openLayer].firstDraw) {
+                layers.pop_back();
+            }
+            openLayer = -1;
+        }
+    };
+    RocketBgfxFrameArena *                                    _frameArena;        // destroyed, not deleted
+    Recorder                                                  _mainRecorder;
+    std::unordered_map<std::thread::id, std::unique_ptr<Recorder>> _recorders;    // other threads
+    std::mutex                                                _recordersMutex;
+    std::thread::id                                           _apiThread;         // the creating thread, the only one that calls bgfx
+    bool                                                      _threadedRecording;
+    uint64_t                                                  _instance;          // keys the per-thread recorder cache
+
+    // Guards the geometry and texture tables while threaded recording is on: draws take it shared, creates and
+    // releases exclusively. The single threaded default never locks.
+    typedef std::shared_lock<std::shared_timed_mutex> TableReadLock;
+    typedef std::unique_lock<std::shared_timed_mutex> TableWriteLock;
+    mutable std::shared_timed_mutex                           _tableMutex;
+
+    // bgfx work requested by recording threads, carried out by frame(): creates before it submits, releases after
+    struct PendingGeometry {
+        uint32_t                      handle;
+        std::vector<RocketVertexData> vertices;
+        std::vector<uint16_t>         indices;
+        std::vector<uint32_t>         wideIndices;      // used instead when there are too many vertices for 16 bits
+    };
+    struct PendingTexture {
+        uint32_t                        handle;
+        std::vector<Rocket::Core::byte> pixels;
+        int                             width, height;
+        std::unique_ptr<RocketBgfxMappedFile> container;    // a KTX/DDS file to create it from instead of pixels
+        RocketBgfxTextureContainer::Info      containerInfo;
+        TextureStorage                        storage;          // pixels hold one byte per texel unless Rgba
+        const RocketBgfxBundle::Asset *       bundled;          // a bundled image or KTX/DDS file to create it from instead
+    };
+    struct DeferredWork {
+        std::vector<PendingGeometry>     geometryCreates;
+        std::vector<PendingTexture>      textureCreates;
+        std::vector<uint32_t>            geometryReleases;
+        std::vector<bgfx::TextureHandle> textureDestroys;
+        std::vector<RocketBgfxTextureAtlas::Region> atlasReleases;
+
+        void clear() { geometryCreates.clear(); textureCreates.clear(); geometryReleases.clear(); textureDestroys.clear(); atlasReleases.clear(); }
+    };
+    DeferredWork                                              _deferredWork;      // since the last frame(), or commitFrame()
+
+    // Decoupled recording hands frames over whole: every queue in submission order, and the work they deferred.
+    // The recording thread fills the committed frame while frame() draws the submitted one.
+    struct RecordedFrame {
+        std::vector<Recorder> queues;
+        DeferredWork          work;
+    };
+    RecordedFrame                                             _committedFrame;
+    RecordedFrame                                             _submittedFrame;
+    bool                                                      _frameCommitted;    // waiting for frame() to pick it up
+    bool                                                      _decoupled;
+    std::atomic<uint64_t>                                     _framesCommitted;
+    std::mutex                                                _commitMutex;
+    std::condition_variable                                   _commitConsumed;
+
+    RocketBgfxGeometryRing                                    _dynamicGeometry;
+    RocketBgfxSubmitter                                       _submitter;         // creates its uniforms, so bgfx must be initialized first
+
+    float _width;
+    float _height;
+    bool  _viewCulling;     // drop draws outside (0, 0, _width, _height), see setViewCulling()
+
+    // A retained layer: the texture its draws were rendered into, the framebuffer doing that and the quad compositing it
+    struct Layer {
+        bgfx::FrameBufferHandle  frameBuffer;
+        bgfx::TextureHandle      texture;
+        bgfx::VertexBufferHandle quad;
+        uint16_t                 width, height;
+        uint64_t                 signature;
+        bool                     valid;         // the texture holds the draws signature was taken from
+        uint64_t                 lastUsed;      // layer frame it was last composited in
     };
-    viewScissor_t _scissorParams;
+    std::unordered_map<uint32_t, Layer>                       _layers;
+    bgfx::IndexBufferHandle                                   _layerQuadIndices;  // shared by every layer quad, created on demand
+    uint8_t                                                   _firstLayerView;
+    uint8_t                                                   _layerViews;        // 0 disables layers
+    uint8_t                                                   _layerViewsUsed;    // this frame
+    uint64_t                                                  _layerBudget;
+    uint64_t                                                  _layerFrame;
+
+public:
+    // Counters for the last frame() call
+    struct BatchStats {
+        uint32_t queuedDraws;       // RenderGeometry + RenderCompiledGeometry calls
+        uint32_t submittedDraws;    // bgfx::submit calls
+        uint32_t mergedDraws;       // dynamic draws folded into a preceding batch
+        uint32_t instancedDraws;    // compiled draws folded into a preceding instanced submit
+        uint32_t culledDraws;       // draws dropped for lying entirely outside their scissor or the view
+        uint32_t scissorChanges;    // distinct scissor rects pushed into bgfx's scissor cache
+        uint32_t programChanges;    // submits using a different program than the one before
+        uint32_t textureChanges;    // textured submits using a different texture than the one before
+        uint32_t uniformUpdates;    // translation uniform writes
+        uint32_t avoidedStateChanges; // uniform writes skipped as redundant
+    };
+    // Layer cache counters since construction
+    struct LayerStats {
+        uint32_t hits;              // layers composited straight from their texture
+        uint32_t misses;            // ... rendered into it first
+        uint32_t bypassed;          // drawn directly, for lack of a layer view or budget
+        uint32_t evictions;         // textures dropped to stay within the budget
+        uint32_t layers;            // holding a texture now
+        uint64_t textureBytes;
+
+        float hitRate() const noexcept { return hits + misses ? float(hits) / float(hits + misses) : 0.0f; }
+    };
+private:
+    BatchStats _batchStats;
+    LayerStats _layerStats;
+
+    RocketBgfxFrameStats _frameStats;           // accumulating since the last frame()
+    RocketBgfxFrameStats _lastFrameStats;
+    uint64_t             _bytesCopiedSnapshot;  // component upload totals when _frameStats was reset
+    RocketBgfxTrace *    _trace;
+
+    std::unique_ptr<RocketBgfxCaptureWriter> _capture;
+
+    const TextureEntry * findTexture(Rocket::Core::TextureHandle texture) const noexcept;
+    static bool convertVertices(const Rocket::Core::Vertex * vertices, int num_vertices, const Rocket::Core::Vector2f & translation,
+        const TextureEntry * texture, RocketVertexData * out) noexcept;
+    void appendSplitGeometry(Recorder & recorder, const Rocket::Core::Vertex * vertices, int num_vertices, const int * indices, int num_indices,
+        const TextureEntry * texture, Rocket::Core::TextureHandle textureHandle, const Rocket::Core::Vector2f & translation);
+    static Bounds computeBounds(const Rocket::Core::Vertex * vertices, int num_vertices) noexcept;
+    static Rocket::Core::Vector2f positionOrigin(const Bounds & bounds, bool & fits) noexcept;
+    bool culls(const Recorder & recording, const Bounds & translated) const noexcept {
+        return recording.scissor.excludes(translated)
+            || (_viewCulling && (translated.maxX <= 0.0f || translated.maxY <= 0.0f || translated.minX >= _width || translated.minY >= _height));
+    }
+    void submitQueuedDraws(const std::vector<Recorder *> & recorders);
+    typedef std::vector<std::pair<viewScissor_t, uint16_t>> ScissorCache;   // a UI frame only has a handful of rects
+    void submitRecorder(const Recorder & recorder, ScissorCache & scissorCache);
+    void submitDraws(const std::vector<DrawRecord> & draws, size_t first, size_t end, const RocketBgfxGeometryRing::Allocation & dynamic,
+        uint32_t numVertices, const LayerSpan * layer, ScissorCache & scissorCache);
+    bool drawLayer(const LayerSpan & span, const Recorder & recorder, const RocketBgfxGeometryRing::Allocation & dynamic,
+        uint32_t numVertices, ScissorCache & scissorCache);
+    bool allocateLayer(Layer & layer, uint16_t width, uint16_t height);
+    void destroyLayer(Layer & layer);
+    void signLayerDraw(Recorder & recorder, uint64_t geometry, Rocket::Core::TextureHandle texture, const TextureEntry * entry,
+        const Rocket::Core::Vector2f & translation);
+    bool resolveLateGeometry(DrawRecord & draw) const noexcept;
+    void runDeferredCreates(DeferredWork & work);
+    void runDeferredReleases(DeferredWork & work);
+    void drawCommittedFrame();
+    Recorder & recorder();
+    std::vector<Recorder *> recordersInOrder();
+    bool deferBgfx() const noexcept { return _threadedRecording && std::this_thread::get_id() != _apiThread; }
+    TableReadLock readTables() const { return _threadedRecording ? TableReadLock(_tableMutex) : TableReadLock(); }
+    TableWriteLock writeTables() { return _threadedRecording ? TableWriteLock(_tableMutex) : TableWriteLock(); }
+    bgfx::TextureHandle drawTexture(const TextureEntry * texture, uint32_t & lateTexture, Rocket::Core::TextureHandle handle) const noexcept;
+    bool loadTexture(Rocket::Core::TextureHandle& texture_handle, Rocket::Core::Vector2i& texture_dimensions, const Rocket::Core::String& source);
+    bool loadContainer(Rocket::Core::TextureHandle& texture_handle, Rocket::Core::Vector2i& texture_dimensions, const Rocket::Core::String& source);
+    bool openContainer(const std::string & path, std::unique_ptr<RocketBgfxMappedFile> & file, RocketBgfxTextureContainer::Info & info, std::string & error);
+    void createContainerTexture(std::unique_ptr<RocketBgfxMappedFile> file, const RocketBgfxTextureContainer::Info & info, TextureEntry & entry);
+    bool loadFromBundle(Rocket::Core::TextureHandle& texture_handle, Rocket::Core::Vector2i& texture_dimensions, const Rocket::Core::String& source,
+        const RocketBgfxBundle::Asset & asset);
+    void createBundleTexture(const RocketBgfxBundle::Asset & asset, TextureEntry & entry);
+    bool generateTexture(Rocket::Core::TextureHandle& texture_handle, const Rocket::Core::byte* source, const Rocket::Core::Vector2i& source_dimensions,
+        bool generated = true);
+    void publishFrameStats();
+    uint64_t componentBytesCopied() const noexcept;
+    bgfx::ProgramHandle programFor(bgfx::TextureHandle texture) const noexcept {
+        switch (storageOf(texture)) {
+        case TextureStorage::Alpha:         return _alphaShader;
+        case TextureStorage::DistanceField: return _distanceFieldShader;
+        default:                            return bgfx::isValid(texture) ? _textureShader : _colorShader;
+        }
+    }
+    bgfx::ProgramHandle instancedProgramFor(bgfx::TextureHandle texture) const noexcept { return bgfx::isValid(texture) ? _textureInstancedShader : _colorInstancedShader; }
+    bool instancing() const noexcept { return bgfx::isValid(_colorInstancedShader) && bgfx::isValid(_textureInstancedShader); }
+    void createTexture(const Rocket::Core::byte * source, int width, int height, TextureEntry & entry);
+    void createSingleChannelTexture(const uint8_t * texels, int width, int height, TextureStorage storage, TextureEntry & entry);
+    void destroyTexture(bgfx::TextureHandle texture);
+    TextureStorage storageOf(bgfx::TextureHandle texture) const noexcept {
+        return bgfx::isValid(texture) && texture.idx < _textureStorage.size() ? _textureStorage[texture.idx] : TextureStorage::Rgba;
+    }
+    bool restorable(const TextureEntry & entry) const noexcept {
+        return !entry.atlased && !entry.loadTicket && !entry.sharedWith && (!entry.retained.empty() || !entry.source.empty());
+    }
+    bool overUploadBudget(uint64_t bytes) const noexcept { return _textureUploadBudget && _textureUploadBytes + bytes > _textureUploadBudget; }
+    void queueTextureUpload(uint32_t handle, std::vector<uint8_t> texels, int width, int height, TextureStorage storage);
+    void uploadTextureRows();
+    void restoreDrawnTextures(const std::vector<Recorder *> & recorders);
+    void restoreTexture(uint32_t handle, TextureEntry & entry);
+    void enforceTextureBudget();
+    void registerTextureHash(uint32_t texture, TextureEntry & entry, uint64_t hash);
+    void forgetTextureKeys(uint32_t texture, TextureEntry & entry);
+    void releaseTexture(uint32_t texture);
+    uint32_t findLoadedTexture(uint64_t hash, int width, int height) const;
+    // The entry a draw of this one samples
+    uint32_t sharedTexture(uint32_t texture) const noexcept {
+        const TextureEntry * entry = _textureBuffers.contains(texture) ? _textureBuffers.find(texture) : nullptr;
+        return entry && entry->sharedWith ? entry->sharedWith : texture;
+    }
+    bgfx::TextureHandle placeholderTexture();
+    void finishTextureLoads(bool drain = false);
+    void reportTextureLoadFailure(const Rocket::Core::String & source, const std::string & reason);
 
     RocketBgfxInterface(const RocketBgfxInterface&) = delete; // non construction-copyable
     RocketBgfxInterface& operator=(const RocketBgfxInterface&) = delete; // non copyable
@@ -75,14 +520,139 @@ public:
     void setTextureShader(bgfx::ProgramHandle shader) noexcept { _colorShader = shader; }
     bgfx::ProgramHandle getColorShader() const noexcept { return _colorShader; }
     bgfx::ProgramHandle getTextureShader() const noexcept { return _textureShader; }
+    /// Programs built from vs_BgfxRocketRenderTestInstanced and the usual fragment shaders. With them, consecutive
+    /// draws of the same compiled geometry (list rows, grid cells) go out as one instanced submit. Ignored when the
+    /// renderer lacks instancing.
+    void setInstancedShaders(bgfx::ProgramHandle colorShader, bgfx::ProgramHandle textureShader) noexcept;
+    /// Program built from vs_BgfxRocketRenderTest and fs_BgfxRocketRenderTestAlpha. With it, the pages libRocket
+    /// generates white with coverage in alpha, its glyph pages, are stored as R8, a quarter of their RGBA8 size.
+    /// Set it before loading documents and keep it for the interface's lifetime.
+    void setAlphaShader(bgfx::ProgramHandle shader) noexcept { _alphaShader = shader; }
+    bgfx::ProgramHandle getAlphaShader() const noexcept { return _alphaShader; }
+    /// Program built from vs_BgfxRocketRenderTest and fs_BgfxRocketRenderTestDistance. With it, the glyph pages
+    /// libRocket generates from then on are stored as single-channel distance fields instead, and drawn with it: text
+    /// stays sharp when the UI is magnified, and gets the outline and shadow of setDistanceFieldStyle(). Takes
+    /// precedence over setAlphaShader(), and the same lifetime applies.
+    void setDistanceFieldShader(bgfx::ProgramHandle shader) noexcept { _distanceFieldShader = shader; }
+    bgfx::ProgramHandle getDistanceFieldShader() const noexcept { return _distanceFieldShader; }
+    void setDistanceFieldStyle(const RocketBgfxSubmitter::DistanceFieldStyle & style) noexcept { _submitter.setDistanceFieldStyle(style); }
+    const RocketBgfxSubmitter::DistanceFieldStyle & getDistanceFieldStyle() const noexcept { return _submitter.getDistanceFieldStyle(); }
 
     void setViewNumber(int viewNumber) noexcept { _viewNumber = viewNumber; }
     int getViewNumber() const noexcept { return _viewNumber; }
 
     void setViewParameters(int viewNumber = -1);
+    /// Drop draws that lie entirely outside the view rect, on top of those outside Rocket's scissor. setViewParameters()
+    /// turns it on, as the view it sets up shows exactly that rect; turn it off when the UI is drawn through a
+    /// transform of your own that can show more of it.
+    void setViewCulling(bool enabled) noexcept { _viewCulling = enabled; }
+    bool getViewCulling() const noexcept { return _viewCulling; }
     
     void frame();
 
+    const BatchStats & getBatchStats() const noexcept { return _batchStats; }
+
+    /// Counters and CPU timings covering everything since the previous frame(), up to and including the last one
+    const RocketBgfxFrameStats & getFrameStats() const noexcept { return _lastFrameStats; }
+    /// The blocks dynamic geometry is recorded into and lent to bgfx from
+    RocketBgfxFrameArena::Stats getFrameArenaStats() const { return _frameArena->getStats(); }
+    /// Record CPU time spent in the interface into a trace, nullptr to stop. The trace must outlive the interface or be detached.
+    void setTrace(RocketBgfxTrace * trace) noexcept { _trace = trace; }
+    RocketBgfxTrace * getTrace() const noexcept { return _trace; }
+
+    /// Record every Rocket call from now on into a capture file, for RocketBgfxCaptureReplayer. Handles created
+    /// before the capture started are unknown to the replay, so start it before loading documents.
+    /// With threaded recording the calls of all threads go into the one capture, interleaved.
+    bool startCapture(const std::string & path);
+    void stopCapture() { _capture.reset(); }
+    bool isCapturing() const noexcept { return _capture != nullptr; }
+
+    /// Pre-size the dynamic geometry ring, e.g. from the high-water mark of a previous session
+    void reserveDynamicGeometry(uint32_t vertices, uint32_t indices) { _dynamicGeometry.reserve(vertices, indices); }
+    const RocketBgfxGeometryRing::Stats & getDynamicGeometryStats() const noexcept { return _dynamicGeometry.getStats(); }
+
+    /// Arena usage and fragmentation for compiled geometry
+    RocketBgfxGeometryArena::Stats getCompiledGeometryStats() const noexcept { return _compiledGeometry.getStats(); }
+    /// Incrementally move compiled geometry out of fragmented arenas, see RocketBgfxGeometryArena::setCompaction
+    void setCompiledGeometryCompaction(bool enabled, float threshold = 0.5f) noexcept { _compiledGeometry.setCompaction(enabled, threshold); }
+
+    /// Pack small generated and loaded textures into shared atlas pages. Only affects textures created afterwards.
+    void setTextureAtlasEnabled(bool enabled) noexcept { _textureAtlasEnabled = enabled; }
+    bool getTextureAtlasEnabled() const noexcept { return _textureAtlasEnabled; }
+    RocketBgfxTextureAtlas::Stats getTextureAtlasStats() const noexcept { return _textureAtlas.getStats(); }
+
+    /// Decode LoadTexture images on this many worker threads, 0 decodes them synchronously inside LoadTexture.
+    /// Asynchronous loads hand Rocket a transparent placeholder until frame() swaps in the decoded image.
+    void setTextureLoaderThreads(unsigned threads);
+    unsigned getTextureLoaderThreads() const noexcept { return _textureLoaderThreads; }
+    /// Cap on the decoded images frame() uploads, which spreads the cost of opening an image heavy document
+    void setTextureUploadsPerFrame(uint32_t uploads) noexcept { _textureUploadsPerFrame = uploads; }
+    uint32_t getTextureUploadsPerFrame() const noexcept { return _textureUploadsPerFrame; }
+    /// Images still decoding or waiting for their upload
+    size_t getPendingTextureLoads() const noexcept { return _pendingTextures.size(); }
+    /// Called instead of throwing when an image can't be loaded, by default the failure is written to std::cerr
+    void setTextureLoadFailedCallback(TextureLoadFailedCallback callback) { _textureLoadFailed = std::move(callback); }
+    /// GPU memory Rocket's textures may hold, 0 for no limit. Past it frame() destroys the least recently drawn ones
+    /// that can be created again: loaded images and KTX/DDS files from their file, generated textures from a CPU copy
+    /// kept while there is a budget. An evicted texture is created again before the frame that draws it is submitted;
+    /// images decoded on loader threads show the placeholder until they are back. Atlas pages and textures drawn in
+    /// the current frame always stay. Set it before loading documents.
+    void setTextureBudget(uint64_t bytes) noexcept { _textureBudget = bytes; }
+    uint64_t getTextureBudget() const noexcept { return _textureBudget; }
+    /// Texture bytes uploaded per frame, 0 for no limit. A generated or decoded texture that doesn't fit in what is left
+    /// of the frame's share is uploaded by frame() a band of rows at a time instead, and shows the placeholder until
+    /// its last row is in. Restored textures and KTX/DDS files always go up whole.
+    void setTextureUploadBudget(uint64_t bytes) noexcept { _textureUploadBudget = bytes; }
+    uint64_t getTextureUploadBudget() const noexcept { return _textureUploadBudget; }
+    const TextureResidencyStats & getTextureResidencyStats() const noexcept { return _textureResidencyStats; }
+    /// Serve LoadTexture from a bundle written by BgfxRocketBundleTool, nullptr loads from disk again. Bundled images
+    /// are already decoded and bgfx reads their texels and KTX/DDS files straight out of the mapping, so the bundle must
+    /// outlive the interface. Sources the bundle doesn't have still load from disk.
+    void setAssetBundle(const RocketBgfxBundle * bundle) noexcept { _assetBundle = bundle; }
+    const RocketBgfxBundle * getAssetBundle() const noexcept { return _assetBundle; }
+
+    /// Compiled geometry is shared by content, see CompiledGeometry
+    const GeometryCacheStats & getGeometryCacheStats() const noexcept { return _geometryCacheStats; }
+    /// Textures are shared by source path and by pixel content, see TextureEntry
+    const TextureCacheStats & getTextureCacheStats() const noexcept { return _textureCacheStats; }
+    /// Texture memory and the time spent loading
+    const TextureLoadStats & getTextureLoadStats() const noexcept { return _textureLoadStats; }
+
+    /// Accept Rocket calls from threads other than the one that created the interface, e.g. a context per worker
+    /// thread. Each thread records into its own queue and the bgfx work those threads cause is deferred to frame(),
+    /// which must still run on the creating thread once the recording threads are done with the frame.
+    /// Switch it on and off on the creating thread while no other thread is recording.
+    void setThreadedRecording(bool enabled);
+    bool getThreadedRecording() const noexcept { return _threadedRecording; }
+    /// Where the calling thread's draws go in the frame, lower first. The creating thread's draws start at 0, other
+    /// threads default to the order they first recorded in.
+    void setRecordingOrder(int order) { recorder().order = order; }
+
+    /// Run libRocket's Update/Render on a thread of its own, overlapped with the bgfx thread drawing the frame before.
+    /// Turns threaded recording on. The recording thread calls commitFrame() after Context::Render; frame() draws the
+    /// newest committed frame, or the previous one again when nothing new was committed.
+    /// Switch it on the creating thread while no other thread is recording.
+    void setDecoupledRecording(bool enabled);
+    bool getDecoupledRecording() const noexcept { return _decoupled; }
+    /// Hand everything recorded since the last commit to frame(), once every recording thread is done with the frame.
+    /// Waits while frame() hasn't picked up the previous commit, so recording runs at most one frame ahead.
+    void commitFrame();
+    uint64_t getFramesCommitted() const noexcept { return _framesCommitted; }
+
+    /// Render what Rocket draws until endLayer() into a texture covering the rect, and composite that instead of the
+    /// draws for as long as they stay the same: the layer is drawn again when anything inside it moves or changes.
+    /// Wrap a static document's context->Render() with it, for example. Layers don't nest. Needs setLayerViews().
+    void beginLayer(uint32_t id, int x, int y, int width, int height);
+    void endLayer() { recorder().closeLayer(); }
+    /// Draw the layer again next time, for changes its draws don't show (e.g. a texture's pixels)
+    void invalidateLayer(uint32_t id) { recorder().invalidatedLayers.push_back(id); }
+    /// Views layers are rendered in, one per layer redrawn in a frame. They must come before the interface's own view.
+    void setLayerViews(uint8_t firstView, uint8_t count) noexcept { _firstLayerView = firstView; _layerViews = count; }
+    /// Texture memory layers may use, the least recently composited ones are dropped to stay within it
+    void setLayerBudget(uint64_t bytes) noexcept { _layerBudget = bytes; }
+    uint64_t getLayerBudget() const noexcept { return _layerBudget; }
+    const LayerStats & getLayerStats() const noexcept { return _layerStats; }
+
     // Rocket functions
     virtual void RenderGeometry(Rocket::Core::Vertex* vertices, int num_vertices, int* indices, int num_indices, Rocket::Core::TextureHandle texture, const Rocket::Core::Vector2f& translation) override;
     virtual Rocket::Core::CompiledGeometryHandle CompileGeometry(Rocket::Core::Vertex* vertices, int num_vertices, int* indices, int num_indices, Rocket::Core::TextureHandle texture) override;
@@ -0,0 +1,106 @@
+#include "RocketBgfxMappedFile.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+RocketBgfxMappedFile::RocketBgfxMappedFile()
+    : _data(nullptr), _size(0)
+#ifdef _WIN32
+    , _file(nullptr), _mapping(nullptr)
+#endif
+{
+}
+RocketBgfxMappedFile::RocketBgfxMappedFile(const std::string & path)
+    : RocketBgfxMappedFile()
+{
+    open(path);
+}
+RocketBgfxMappedFile::~RocketBgfxMappedFile() {
+    close();
+}
+RocketBgfxMappedFile::RocketBgfxMappedFile(RocketBgfxMappedFile && other) noexcept
+    : RocketBgfxMappedFile()
+{
+    *this = std::move(other);
+}
+RocketBgfxMappedFile& RocketBgfxMappedFile::operator=(RocketBgfxMappedFile && other) noexcept {
+    if (this != &other) {
+        close();
+        std::swap(_data, other._data);
+        std::swap(_size, other._size);
+#ifdef _WIN32
+        std::swap(_file, other._file);
+        std::swap(_mapping, other._mapping);
+#endif
+    }
+    return *this;
+}
+// Empty files can't be mapped and are treated as missing
+bool RocketBgfxMappedFile::open(const std::string & path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void * data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!data) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    _file = file;
+    _mapping = mapping;
+    _size = static_cast<size_t>(size.QuadPart);
+#else
+    const int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0) {
+        ::close(file);
+        return false;
+    }
+    void * data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);  // the mapping keeps the file alive
+    if (data == MAP_FAILED)
+        return false;
+
+    _size = static_cast<size_t>(info.st_size);
+#endif
+    _data = static_cast<const uint8_t *>(data);
+    return true;
+}
+void RocketBgfxMappedFile::close() {
+    if (!_data)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(_data);
+    CloseHandle(static_cast<HANDLE>(_mapping));
+    CloseHandle(static_cast<HANDLE>(_file));
+    _file = nullptr;
+    _mapping = nullptr;
+#else
+    munmap(const_cast<uint8_t *>(_data), _size);
+#endif
+    _data = nullptr;
+    _size = 0;
+}
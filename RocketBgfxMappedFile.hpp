@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// A read-only memory mapping of a whole file. The pages are only read in as they are touched, so large captures,
+// bundles or textures cost nothing up front and nothing has to be copied out of them.
+class RocketBgfxMappedFile
+{
+public:
+    RocketBgfxMappedFile();
+    explicit RocketBgfxMappedFile(const std::string & path);
+    ~RocketBgfxMappedFile();
+
+    RocketBgfxMappedFile(RocketBgfxMappedFile && other) noexcept;
+    RocketBgfxMappedFile& operator=(RocketBgfxMappedFile && other) noexcept;
+
+    bool open(const std::string & path);
+    void close();
+
+    bool isOpen() const noexcept { return _data != nullptr; }
+    const uint8_t * data() const noexcept { return _data; }
+    size_t size() const noexcept { return _size; }
+
+private:
+    RocketBgfxMappedFile(const RocketBgfxMappedFile&) = delete; // non construction-copyable
+    RocketBgfxMappedFile& operator=(const RocketBgfxMappedFile&) = delete; // non copyable
+
+    const uint8_t * _data;
+    size_t          _size;
+#ifdef _WIN32
+    void *          _file;
+    void *          _mapping;
+#endif
+};
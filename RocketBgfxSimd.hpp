@@ -0,0 +1,202 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "RocketBgfxHash.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ROCKETBGFX_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ROCKETBGFX_NEON 1
+#endif
+
+// Vectorized scans over texture and vertex data, with SSE2 on x86, NEON on ARM and a scalar loop elsewhere. Each
+// function gives the same result on every path, the scalar one handles the tails.
+class RocketBgfxSimd
+{
+public:
+    /// Whether every RGBA8 texel has white color channels, so that only its alpha carries information
+    static bool isWhite(const uint8_t * rgba, size_t texels) noexcept {
+        size_t t = 0;
+#if defined(ROCKETBGFX_SSE2)
+        const __m128i alpha = _mm_set1_epi32(int(0xFF000000u));
+        const __m128i ones = _mm_set1_epi32(-1);
+        for (; t + 16 <= texels; t += 16) {
+            const __m128i * p = reinterpret_cast<const __m128i *>(rgba + t * 4);
+            const __m128i all = _mm_and_si128(_mm_and_si128(_mm_loadu_si128(p), _mm_loadu_si128(p + 1)),
+                                              _mm_and_si128(_mm_loadu_si128(p + 2), _mm_loadu_si128(p + 3)));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_or_si128(all, alpha), ones)) != 0xFFFF)
+                return false;
+        }
+#elif defined(ROCKETBGFX_NEON)
+        for (; t + 16 <= texels; t += 16) {
+            const uint8x16x4_t texel = vld4q_u8(rgba + t * 4);
+            const uint8x16_t all = vandq_u8(vandq_u8(texel.val[0], texel.val[1]), texel.val[2]);
+            const uint8x8_t half = vand_u8(vget_low_u8(all), vget_high_u8(all));
+            if (vget_lane_u64(vreinterpret_u64_u8(half), 0) != ~0ULL)
+                return false;
+        }
+#endif
+        for (; t < texels; ++t) {
+            if ((rgba[t * 4] & rgba[t * 4 + 1] & rgba[t * 4 + 2]) != 0xFF)
+                return false;
+        }
+        return true;
+    }
+
+    /// Copies the alpha channel of RGBA8 texels, one byte per texel
+    static void extractAlpha(const uint8_t * rgba, size_t texels, uint8_t * alpha) noexcept {
+        size_t t = 0;
+#if defined(ROCKETBGFX_SSE2)
+        for (; t + 16 <= texels; t += 16) {
+            const __m128i * p = reinterpret_cast<const __m128i *>(rgba + t * 4);
+            const __m128i low = _mm_packs_epi32(_mm_srli_epi32(_mm_loadu_si128(p), 24), _mm_srli_epi32(_mm_loadu_si128(p + 1), 24));
+            const __m128i high = _mm_packs_epi32(_mm_srli_epi32(_mm_loadu_si128(p + 2), 24), _mm_srli_epi32(_mm_loadu_si128(p + 3), 24));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(alpha + t), _mm_packus_epi16(low, high));
+        }
+#elif defined(ROCKETBGFX_NEON)
+        for (; t + 16 <= texels; t += 16) {
+            vst1q_u8(alpha + t, vld4q_u8(rgba + t * 4).val[3]);
+        }
+#endif
+        for (; t < texels; ++t) {
+            alpha[t] = rgba[t * 4 + 3];
+        }
+    }
+
+    /// Axis-aligned bounds of `count` 2D float positions `stride` bytes apart, as min x, min y, max x, max y. Two
+    /// positions go through every min/max, so strided vertex data needs no gather.
+    static void bounds(const void * positions, size_t count, size_t stride, float * minMax) noexcept {
+        const uint8_t * p = static_cast<const uint8_t *>(positions);
+        float first[2];
+        std::memcpy(first, p, sizeof(first));
+        minMax[0] = minMax[2] = first[0];
+        minMax[1] = minMax[3] = first[1];
+        size_t v = 1;
+#if defined(ROCKETBGFX_SSE2)
+        if (count >= 3) {
+            __m128 low = _mm_setr_ps(first[0], first[1], first[0], first[1]);
+            __m128 high = low;
+            for (; v + 2 <= count; v += 2) {
+                const __m128 pair = _mm_castsi128_ps(_mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p + v * stride)),
+                                                                        _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p + (v + 1) * stride))));
+                low = _mm_min_ps(low, pair);
+                high = _mm_max_ps(high, pair);
+            }
+            low = _mm_min_ps(low, _mm_movehl_ps(low, low));
+            high = _mm_max_ps(high, _mm_movehl_ps(high, high));
+            _mm_storel_pi(reinterpret_cast<__m64 *>(minMax), low);
+            _mm_storel_pi(reinterpret_cast<__m64 *>(minMax + 2), high);
+        }
+#elif defined(ROCKETBGFX_NEON)
+        if (count >= 3) {
+            float32x4_t low = vcombine_f32(vld1_f32(first), vld1_f32(first));
+            float32x4_t high = low;
+            for (; v + 2 <= count; v += 2) {
+                const float32x4_t pair = vcombine_f32(vld1_f32(reinterpret_cast<const float *>(p + v * stride)),
+                                                      vld1_f32(reinterpret_cast<const float *>(p + (v + 1) * stride)));
+                low = vminq_f32(low, pair);
+                high = vmaxq_f32(high, pair);
+            }
+            vst1_f32(minMax, vmin_f32(vget_low_f32(low), vget_high_f32(low)));
+            vst1_f32(minMax + 2, vmax_f32(vget_low_f32(high), vget_high_f32(high)));
+        }
+#endif
+        for (; v < count; ++v) {
+            float position[2];
+            std::memcpy(position, p + v * stride, sizeof(position));
+            minMax[0] = position[0] < minMax[0] ? position[0] : minMax[0];
+            minMax[1] = position[1] < minMax[1] ? position[1] : minMax[1];
+            minMax[2] = position[0] > minMax[2] ? position[0] : minMax[2];
+            minMax[3] = position[1] > minMax[3] ? position[1] : minMax[3];
+        }
+    }
+
+    /// 64-bit content hash for large inputs, not the value RocketBgfxHash::compute gives. Eight 64-bit lanes each take
+    /// a 32x32 bit product and a neighbour's input per 64-byte stripe (the XXH3 accumulation), which vectorizes where
+    /// xxHash64's 64-bit multiplies do not. Inputs under a stripe go to RocketBgfxHash directly.
+    static uint64_t hash(const void * data, size_t size, uint64_t seed = 0) noexcept {
+        const uint8_t * p = static_cast<const uint8_t *>(data);
+        if (size < STRIPE)
+            return RocketBgfxHash::compute(p, size, seed);
+
+        alignas(16) uint64_t acc[8];
+        const uint64_t * const key = keys();
+        for (int lane = 0; lane < 8; ++lane) {
+            acc[lane] = key[lane] + seed;
+        }
+        const size_t stripes = size / STRIPE;
+        for (size_t block = 0; block < stripes; block += STRIPES_PER_SCRAMBLE) {
+            accumulate(acc, p + block * STRIPE, block + STRIPES_PER_SCRAMBLE <= stripes ? STRIPES_PER_SCRAMBLE : stripes - block);
+            // Folds the high bits back in before the sums lose them
+            for (int lane = 0; lane < 8; ++lane) {
+                acc[lane] = ((acc[lane] ^ (acc[lane] >> 47)) ^ key[7 - lane]) * 0x9E3779B1u;
+            }
+        }
+        return RocketBgfxHash::compute(p + stripes * STRIPE, size - stripes * STRIPE, RocketBgfxHash::compute(acc, sizeof(acc), seed + size));
+    }
+
+private:
+    constexpr static const size_t STRIPE = 64;
+    constexpr static const size_t STRIPES_PER_SCRAMBLE = 16;
+    static const uint64_t * keys() noexcept {
+        static const uint64_t values[8] = {
+            0xBE4BA423396CFEB8ULL, 0x1CAD21F72C81017CULL, 0xDB979083E96DD4DEULL, 0x1F67B3B7A4A44072ULL,
+            0x78E5C0CC4EE679CBULL, 0x2172FFCC7DD05A82ULL, 0x8E2443F7744608B8ULL, 0x4C263A81E69035E0ULL,
+        };
+        return values;
+    }
+
+    static void accumulate(uint64_t * acc, const uint8_t * p, size_t stripes) noexcept {
+        const uint64_t * const key = keys();
+#if defined(ROCKETBGFX_SSE2)
+        __m128i lanes[4], keys[4];
+        for (int i = 0; i < 4; ++i) {
+            lanes[i] = _mm_load_si128(reinterpret_cast<const __m128i *>(acc) + i);
+            keys[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(key) + i);
+        }
+        for (size_t s = 0; s < stripes; ++s, p += STRIPE) {
+            for (int i = 0; i < 4; ++i) {
+                const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p) + i);
+                const __m128i keyed = _mm_xor_si128(value, keys[i]);
+                const __m128i product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(3, 3, 1, 1)));
+                lanes[i] = _mm_add_epi64(lanes[i], _mm_add_epi64(product, _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2))));
+            }
+        }
+        for (int i = 0; i < 4; ++i) {
+            _mm_store_si128(reinterpret_cast<__m128i *>(acc) + i, lanes[i]);
+        }
+#elif defined(ROCKETBGFX_NEON)
+        uint64x2_t lanes[4], keys[4];
+        for (int i = 0; i < 4; ++i) {
+            lanes[i] = vld1q_u64(acc + i * 2);
+            keys[i] = vld1q_u64(key + i * 2);
+        }
+        for (size_t s = 0; s < stripes; ++s, p += STRIPE) {
+            for (int i = 0; i < 4; ++i) {
+                const uint64x2_t value = vreinterpretq_u64_u8(vld1q_u8(p + i * 16));
+                const uint64x2_t keyed = veorq_u64(value, keys[i]);
+                const uint64x2_t product = vmull_u32(vmovn_u64(keyed), vshrn_n_u64(keyed, 32));
+                lanes[i] = vaddq_u64(lanes[i], vaddq_u64(product, vextq_u64(value, value, 1)));
+            }
+        }
+        for (int i = 0; i < 4; ++i) {
+            vst1q_u64(acc + i * 2, lanes[i]);
+        }
+#else
+        for (size_t s = 0; s < stripes; ++s, p += STRIPE) {
+            for (int lane = 0; lane < 8; ++lane) {
+                uint64_t value;
+                std::memcpy(&value, p + lane * 8, sizeof(value));
+                const uint64_t keyed = value ^ key[lane];
+                acc[lane ^ 1] += value;
+                acc[lane] += (keyed & 0xFFFFFFFFu) * (keyed >> 32);
+            }
+        }
+#endif
+    }
+};
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Generational slot map backing the handles we give to Rocket.
+// Values are stored densely so iterating them is a linear walk; a handle resolves through its slot to the dense
+// index in O(1) without hashing. Each handle encodes the slot index in the low INDEX_BITS bits and the slot's
+// generation above it. Released slots go onto a free list and bump their generation, so a stale handle to a reused
+// slot is caught instead of aliasing the new value. Generations start at 1, so 0 is never a valid handle, which is
+// what Rocket treats as "no texture / no geometry".
+//
+// Pointers returned by find() are only valid until the next insert() or erase().
+template <typename T>
+class RocketBgfxSlotMap
+{
+public:
+    typedef uint32_t Handle;
+
+    constexpr static const uint32_t INDEX_BITS = 20;
+    constexpr static const uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    constexpr static const uint32_t GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+
+    RocketBgfxSlotMap() : _freeHead(INDEX_MASK) {}
+
+    Handle insert(const T & value) {
+        uint32_t index;
+        if (_freeHead != INDEX_MASK) {
+            index = _freeHead;
+            _freeHead = _slots[index].link;
+        }
+        else {
+            assert(_slots.size() < INDEX_MASK && "RocketBgfxSlotMap: out of slots");
+            index = static_cast<uint32_t>(_slots.size());
+            _slots.push_back(Slot{ 1, 0 });
+        }
+
+        _slots[index].link = static_cast<uint32_t>(_values.size());
+        _values.push_back(value);
+        _owners.push_back(index);
+        return (_slots[index].generation << INDEX_BITS) | index;
+    }
+
+    T * find(Handle handle) noexcept {
+        const uint32_t dense = denseIndex(handle);
+        return dense != INDEX_MASK ? &_values[dense] : nullptr;
+    }
+    const T * find(Handle handle) const noexcept {
+        const uint32_t dense = denseIndex(handle);
+        return dense != INDEX_MASK ? &_values[dense] : nullptr;
+    }
+
+    // Whether a handle refers to a live value. Unlike find() this expects stale handles, for callers that hold on to
+    // handles across a release on purpose.
+    bool contains(Handle handle) const noexcept {
+        const uint32_t index = handle & INDEX_MASK;
+        return handle != 0 && index < _slots.size() && _slots[index].generation == (handle >> INDEX_BITS)
+            && _slots[index].link < _owners.size() && _owners[_slots[index].link] == index;
+    }
+
+    // The last value moves into the hole, so the value array stays dense
+    bool erase(Handle handle) {
+        const uint32_t dense = denseIndex(handle);
+        if (dense == INDEX_MASK)
+            return false;
+
+        const uint32_t index = handle & INDEX_MASK;
+        const uint32_t last = static_cast<uint32_t>(_values.size() - 1);
+        if (dense != last) {
+            _values[dense] = std::move(_values[last]);
+            _owners[dense] = _owners[last];
+            _slots[_owners[dense]].link = dense;
+        }
+        _values.pop_back();
+        _owners.pop_back();
+
+        Slot & slot = _slots[index];
+        slot.generation = (slot.generation + 1) & GENERATION_MASK;
+        if (slot.generation == 0)
+            slot.generation = 1;
+        slot.link = _freeHead;
+        _freeHead = index;
+        return true;
+    }
+
+    void clear() {
+        _slots.clear();
+        _values.clear();
+        _owners.clear();
+        _freeHead = INDEX_MASK;
+    }
+
+    size_t size() const noexcept { return _values.size(); }
+    bool empty() const noexcept { return _values.empty(); }
+
+    // Dense iteration over the live values, in no particular order
+    typename std::vector<T>::iterator begin() noexcept { return _values.begin(); }
+    typename std::vector<T>::iterator end() noexcept { return _values.end(); }
+    typename std::vector<T>::const_iterator begin() const noexcept { return _values.begin(); }
+    typename std::vector<T>::const_iterator end() const noexcept { return _values.end(); }
+
+private:
+    struct Slot {
+        uint32_t generation;
+        uint32_t link;          // dense index while alive, next free slot while on the free list
+    };
+
+    // Returns INDEX_MASK for handles that are out of range or stale. Stale handles are a bug on the caller's side,
+    // so debug builds stop right there.
+    uint32_t denseIndex(Handle handle) const noexcept {
+        const uint32_t index = handle & INDEX_MASK;
+        if (handle == 0 || index >= _slots.size())
+            return INDEX_MASK;
+
+        const Slot & slot = _slots[index];
+        if (slot.generation != (handle >> INDEX_BITS)) {
+            assert(false && "RocketBgfxSlotMap: stale handle");
+            return INDEX_MASK;
+        }
+        // Free slots link into the free list instead, so make sure the dense value points back at us
+        return slot.link < _owners.size() && _owners[slot.link] == index ? slot.link : INDEX_MASK;
+    }
+
+    std::vector<Slot>     _slots;
+    std::vector<T>        _values;
+    std::vector<uint32_t> _owners;      // slot index of each dense value
+    uint32_t              _freeHead;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "RocketBgfxTrace.hpp"
+
+#include <cstdint>
+
+// What the render interface did between two frame() calls, frame() itself included
+struct RocketBgfxFrameStats {
+    uint32_t drawCalls;                 // bgfx::submit calls
+    uint32_t verticesUploaded;          // dynamic and newly compiled geometry
+    uint32_t indicesUploaded;
+    uint64_t bytesCopied;               // everything handed to bgfx::copy/alloc: geometry, relocations, texels
+    uint64_t bytesReferenced;           // ... to bgfx::makeRef instead: the dynamic geometry stream, KTX/DDS files
+    uint32_t compiledGeometryCreated;
+    uint32_t compiledGeometryReleased;
+    uint32_t texturesCreated;           // new textures, cache hits excluded
+    uint64_t textureBytes;              // texel bytes those textures were filled with
+    uint32_t scissorChanges;
+    uint32_t clampedGeometry;           // draws and compilations too large for the quantized positions, drawn squashed
+
+    uint32_t renderGeometryCalls;
+    uint32_t compileGeometryCalls;
+    uint64_t renderGeometryNs;          // CPU time inside each entry point
+    uint64_t compileGeometryNs;
+    uint64_t frameNs;
+
+    // Folds in the counters gathered on another recording thread
+    RocketBgfxFrameStats & operator+=(const RocketBgfxFrameStats & other) noexcept {
+        drawCalls += other.drawCalls;
+        verticesUploaded += other.verticesUploaded;
+        indicesUploaded += other.indicesUploaded;
+        bytesCopied += other.bytesCopied;
+        bytesReferenced += other.bytesReferenced;
+        compiledGeometryCreated += other.compiledGeometryCreated;
+        compiledGeometryReleased += other.compiledGeometryReleased;
+        texturesCreated += other.texturesCreated;
+        textureBytes += other.textureBytes;
+        scissorChanges += other.scissorChanges;
+        clampedGeometry += other.clampedGeometry;
+        renderGeometryCalls += other.renderGeometryCalls;
+        compileGeometryCalls += other.compileGeometryCalls;
+        renderGeometryNs += other.renderGeometryNs;
+        compileGeometryNs += other.compileGeometryNs;
+        frameNs += other.frameNs;
+        return *this;
+    }
+};
+
+// Adds the time spent in a scope to a counter, and records it as a trace event when a trace is attached
+class RocketBgfxScopedTimer
+{
+public:
+    RocketBgfxScopedTimer(uint64_t & elapsedNs, RocketBgfxTrace * trace, const char * name) noexcept
+        : _elapsedNs(elapsedNs), _trace(trace), _name(name), _start(RocketBgfxTrace::now())
+    {
+    }
+    ~RocketBgfxScopedTimer() {
+        const uint64_t duration = RocketBgfxTrace::now() - _start;
+        _elapsedNs += duration;
+        if (_trace) {
+            _trace->complete(_name, _start, duration);
+        }
+    }
+
+private:
+    RocketBgfxScopedTimer(const RocketBgfxScopedTimer&) = delete; // non construction-copyable
+    RocketBgfxScopedTimer& operator=(const RocketBgfxScopedTimer&) = delete; // non copyable
+
+    uint64_t &        _elapsedNs;
+    RocketBgfxTrace * _trace;
+    const char *      _name;
+    uint64_t          _start;
+};
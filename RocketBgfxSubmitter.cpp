@@ -0,0 +1,83 @@
+#include "RocketBgfxSubmitter.hpp"
+
+RocketBgfxSubmitter::RocketBgfxSubmitter()
+    : _view(0), _state(STATE_DEFAULT), _translationValid(false), _translation{ 0.0f, 0.0f, 0.0f, 0.0f },
+      _lastProgram(bgfx::invalidHandle), _lastTexture(bgfx::invalidHandle),
+      _distanceStyle{ 1.0f, 0.0f, { 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 0.0f, 0.0f } }, _distanceStyleValid(false),
+      _stats()
+{
+    _textureSampler = bgfx::createUniform("s_texture0", bgfx::UniformType::Uniform1iv);
+    _translationUniform = bgfx::createUniform("u_translation", bgfx::UniformType::Uniform4fv);
+    _distanceParamsUniform = bgfx::createUniform("u_distanceParams", bgfx::UniformType::Uniform4fv);
+    _outlineColorUniform = bgfx::createUniform("u_outlineColor", bgfx::UniformType::Uniform4fv);
+    _shadowColorUniform = bgfx::createUniform("u_shadowColor", bgfx::UniformType::Uniform4fv);
+}
+RocketBgfxSubmitter::~RocketBgfxSubmitter() {
+    bgfx::destroyUniform(_shadowColorUniform);
+    bgfx::destroyUniform(_outlineColorUniform);
+    bgfx::destroyUniform(_distanceParamsUniform);
+    bgfx::destroyUniform(_translationUniform);
+    bgfx::destroyUniform(_textureSampler);
+}
+// Uniform values are kept by bgfx across frames, but another view may have changed them in between
+void RocketBgfxSubmitter::begin(uint8_t view) noexcept {
+    setTarget(view, STATE_DEFAULT);
+    _stats = Stats();
+}
+// bgfx sorts draws by view before it applies their uniforms, so one set for a draw of the other view doesn't carry over
+void RocketBgfxSubmitter::setTarget(uint8_t view, uint64_t state) noexcept {
+    _view = view;
+    _state = state;
+    _translationValid = false;
+    _distanceStyleValid = false;
+    _lastProgram = bgfx::invalidHandle;
+    _lastTexture = bgfx::invalidHandle;
+}
+void RocketBgfxSubmitter::submit(bgfx::ProgramHandle program, bgfx::TextureHandle texture, float translationX, float translationY) {
+    if (!_translationValid || _translation[0] != translationX || _translation[1] != translationY) {
+        _translation[0] = translationX;
+        _translation[1] = translationY;
+        _translationValid = true;
+        bgfx::setUniform(_translationUniform, _translation);
+        _stats.uniformUpdates++;
+    }
+    else {
+        _stats.avoidedStateChanges++;
+    }
+
+    draw(program, texture);
+}
+// The instanced program ignores the translation uniform, so whatever it holds stays valid for the next submit
+void RocketBgfxSubmitter::submitInstanced(bgfx::ProgramHandle program, bgfx::TextureHandle texture) {
+    draw(program, texture);
+}
+void RocketBgfxSubmitter::bindDistanceFieldStyle() {
+    if (_distanceStyleValid) {
+        _stats.avoidedStateChanges++;
+        return;
+    }
+    const float params[4] = { _distanceStyle.softness, _distanceStyle.outlineWidth, _distanceStyle.shadowOffset[0], _distanceStyle.shadowOffset[1] };
+    bgfx::setUniform(_distanceParamsUniform, params);
+    bgfx::setUniform(_outlineColorUniform, _distanceStyle.outlineColor);
+    bgfx::setUniform(_shadowColorUniform, _distanceStyle.shadowColor);
+    _distanceStyleValid = true;
+    _stats.uniformUpdates += 3;
+}
+void RocketBgfxSubmitter::draw(bgfx::ProgramHandle program, bgfx::TextureHandle texture) {
+    if (bgfx::isValid(texture)) {
+        bgfx::setTexture(0, _textureSampler, texture);
+        if (texture.idx != _lastTexture) {
+            _stats.textureChanges++;
+            _lastTexture = texture.idx;
+        }
+    }
+    if (program.idx != _lastProgram) {
+        _stats.programChanges++;
+        _lastProgram = program.idx;
+    }
+
+    bgfx::setProgram(program);
+    bgfx::setState(_state);
+    bgfx::submit(_view);
+    _stats.submits++;
+}
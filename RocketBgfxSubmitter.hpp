@@ -0,0 +1,90 @@
+#pragma once
+
+#include <bgfx.h>
+
+// The last step of every Rocket draw: binds the texture and translation, then submits with the UI render state.
+// The sampler and translation uniforms are created once here instead of per draw, and the draw origin travels as a
+// vec4 uniform rather than a 4x4 matrix in bgfx's transform cache.
+// Only uniforms survive a bgfx::submit, everything else (program, state, texture bindings) is reset for the next
+// draw and has to be set again. So the uniform is the only call that can be skipped when it repeats; repeated
+// programs and textures are merely counted, bgfx's renderer backends already skip rebinding them on the GPU.
+class RocketBgfxSubmitter
+{
+public:
+    // Counters since the last begin()
+    struct Stats {
+        uint32_t submits;
+        uint32_t programChanges;        // draws using a different program than the previous one
+        uint32_t textureChanges;        // textured draws using a different texture than the previous one
+        uint32_t uniformUpdates;        // setUniform calls made
+        uint32_t avoidedStateChanges;   // setUniform calls skipped because the value was already set
+    };
+
+    // UI draws, alpha blended over what is already there
+    constexpr static const uint64_t STATE_DEFAULT = BGFX_STATE_RGB_WRITE
+        | BGFX_STATE_ALPHA_WRITE
+        | BGFX_STATE_MSAA
+        | BGFX_STATE_BLEND_NORMAL;
+    // Into a cleared layer texture: color ends up premultiplied by alpha, and alpha accumulates coverage
+    constexpr static const uint64_t STATE_LAYER = BGFX_STATE_RGB_WRITE
+        | BGFX_STATE_ALPHA_WRITE
+        | BGFX_STATE_BLEND_FUNC_SEPARATE(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA, BGFX_STATE_BLEND_ONE, BGFX_STATE_BLEND_INV_SRC_ALPHA);
+    // A layer texture composited back, its colors are already premultiplied
+    constexpr static const uint64_t STATE_COMPOSITE = BGFX_STATE_RGB_WRITE
+        | BGFX_STATE_ALPHA_WRITE
+        | BGFX_STATE_MSAA
+        | BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_ONE, BGFX_STATE_BLEND_INV_SRC_ALPHA);
+
+    // How fs_BgfxRocketRenderTestDistance draws distance field text. The outline and shadow stay within each glyph's
+    // quad, libRocket sizes those to the glyph's bitmap.
+    struct DistanceFieldStyle {
+        float softness;             // edge blur, 1 is one screen pixel of antialiasing
+        float outlineWidth;         // in distance field units, 0.5 reaches SPREAD texels out; 0 for no outline
+        float shadowOffset[2];      // in screen pixels
+        float outlineColor[4];      // the alphas are multiplied by the vertex color's
+        float shadowColor[4];       // alpha 0 for no shadow
+    };
+
+    RocketBgfxSubmitter();
+    ~RocketBgfxSubmitter();
+
+    /// Start submitting into a view, forgetting all cached state
+    void begin(uint8_t view) noexcept;
+    /// Switch to another view and render state mid-frame, the counters keep running
+    void setTarget(uint8_t view, uint64_t state) noexcept;
+
+    /// Submit the draw whose buffers and scissor are already set. An invalid texture draws untextured.
+    void submit(bgfx::ProgramHandle program, bgfx::TextureHandle texture, float translationX, float translationY);
+    /// Submit a draw whose instance data buffer carries the translations, with a program that reads them
+    void submitInstanced(bgfx::ProgramHandle program, bgfx::TextureHandle texture);
+
+    void setDistanceFieldStyle(const DistanceFieldStyle & style) noexcept { _distanceStyle = style; _distanceStyleValid = false; }
+    const DistanceFieldStyle & getDistanceFieldStyle() const noexcept { return _distanceStyle; }
+    /// Call before submitting a distance field draw, the style's uniforms are only set once per target
+    void bindDistanceFieldStyle();
+
+    const Stats & getStats() const noexcept { return _stats; }
+
+private:
+    RocketBgfxSubmitter(const RocketBgfxSubmitter&) = delete; // non construction-copyable
+    RocketBgfxSubmitter& operator=(const RocketBgfxSubmitter&) = delete; // non copyable
+
+    void draw(bgfx::ProgramHandle program, bgfx::TextureHandle texture);
+
+    bgfx::UniformHandle _textureSampler;
+    bgfx::UniformHandle _translationUniform;
+    bgfx::UniformHandle _distanceParamsUniform;
+    bgfx::UniformHandle _outlineColorUniform;
+    bgfx::UniformHandle _shadowColorUniform;
+
+    uint8_t             _view;
+    uint64_t            _state;
+    bool                _translationValid;
+    float               _translation[4];
+    uint16_t            _lastProgram;
+    uint16_t            _lastTexture;
+    DistanceFieldStyle  _distanceStyle;
+    bool                _distanceStyleValid;
+
+    Stats               _stats;
+};
@@ -0,0 +1,182 @@
+#include "RocketBgfxTextureAtlas.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+RocketBgfxTextureAtlas::RocketBgfxTextureAtlas(uint16_t pageSize, uint16_t maxImageSize, uint16_t padding)
+    : _pageSize(pageSize), _maxImageSize(std::min(maxImageSize, pageSize)), _padding(padding), _bytesUploaded(0)
+{
+}
+RocketBgfxTextureAtlas::~RocketBgfxTextureAtlas() {
+    for (const auto & page : _pages) {
+        bgfx::destroyTexture(page.texture);
+    }
+    _pages.clear();
+}
+bool RocketBgfxTextureAtlas::fits(int width, int height) const noexcept {
+    return width > 0 && height > 0
+        && width <= _maxImageSize && height <= _maxImageSize
+        && width + 2 * _padding <= _pageSize && height + 2 * _padding <= _pageSize;
+}
+// Try every existing page before opening a new one; the first page that fits wins so older pages fill up first.
+bool RocketBgfxTextureAtlas::allocate(uint16_t width, uint16_t height, const uint8_t * rgba, Region & region) {
+    if (!fits(width, height))
+        return false;
+
+    const uint16_t paddedWidth = width + 2 * _padding;
+    const uint16_t paddedHeight = height + 2 * _padding;
+
+    uint16_t x = 0, y = 0;
+    size_t node = 0;
+    size_t pageIndex = 0;
+    for (; pageIndex < _pages.size(); ++pageIndex) {
+        if (findPosition(_pages[pageIndex], paddedWidth, paddedHeight, x, y, node))
+            break;
+    }
+    if (pageIndex == _pages.size()) {
+        createPage();
+        if (!findPosition(_pages.back(), paddedWidth, paddedHeight, x, y, node))
+            return false;
+    }
+
+    Page & page = _pages[pageIndex];
+    insertNode(page, node, x, y, paddedWidth, paddedHeight);
+    page.liveRegions++;
+    page.liveArea += uint64_t(paddedWidth) * paddedHeight;
+
+    region.page = static_cast<uint16_t>(pageIndex);
+    region.x = x + _padding;
+    region.y = y + _padding;
+    region.width = width;
+    region.height = height;
+    region.texture = page.texture;
+    region.u0 = float(region.x) / _pageSize;
+    region.v0 = float(region.y) / _pageSize;
+    region.u1 = float(region.x + width) / _pageSize;
+    region.v1 = float(region.y + height) / _pageSize;
+
+    upload(region, rgba);
+    return true;
+}
+// Released regions keep their old texels, so a reservation without an image is cleared rather than left as is
+void RocketBgfxTextureAtlas::upload(const Region & region, const uint8_t * rgba) {
+    const uint32_t size = uint32_t(region.width) * region.height * sizeof(uint32_t);
+    const bgfx::Memory * memory;
+    if (rgba) {
+        memory = bgfx::copy(rgba, size);
+    }
+    else {
+        memory = bgfx::alloc(size);
+        std::memset(memory->data, 0, size);
+    }
+    bgfx::updateTexture2D(region.texture, 0, region.x, region.y, region.width, region.height, memory);
+    _bytesUploaded += size;
+}
+void RocketBgfxTextureAtlas::release(const Region & region) {
+    if (region.page >= _pages.size())
+        return;
+
+    Page & page = _pages[region.page];
+    page.liveRegions--;
+    page.liveArea -= uint64_t(region.width + 2 * _padding) * (region.height + 2 * _padding);
+
+    if (page.liveRegions == 0) {
+        resetSkyline(page);
+    }
+}
+RocketBgfxTextureAtlas::Stats RocketBgfxTextureAtlas::getStats() const noexcept {
+    Stats stats = Stats();
+    stats.pages = static_cast<uint32_t>(_pages.size());
+    stats.pageArea = uint64_t(_pageSize) * _pageSize * _pages.size();
+    stats.bytesUploaded = _bytesUploaded;
+    for (const auto & page : _pages) {
+        stats.liveRegions += page.liveRegions;
+        stats.liveArea += page.liveArea;
+        for (const auto & node : page.skyline) {
+            stats.usedArea += uint64_t(node.width) * node.y;
+        }
+    }
+    return stats;
+}
+// New pages are cleared once up front so the padding around every image is transparent.
+void RocketBgfxTextureAtlas::createPage() {
+    Page page;
+    page.texture = bgfx::createTexture2D(_pageSize, _pageSize, 1, bgfx::TextureFormat::RGBA8,
+        (BGFX_TEXTURE_U_CLAMP | BGFX_TEXTURE_V_CLAMP) | (BGFX_TEXTURE_MIN_POINT | BGFX_TEXTURE_MAG_POINT));
+    page.liveRegions = 0;
+    page.liveArea = 0;
+    resetSkyline(page);
+
+    const bgfx::Memory * clear = bgfx::alloc(uint32_t(_pageSize) * _pageSize * sizeof(uint32_t));
+    std::memset(clear->data, 0, clear->size);
+    bgfx::updateTexture2D(page.texture, 0, 0, 0, _pageSize, _pageSize, clear);
+    _bytesUploaded += clear->size;
+
+    _pages.push_back(page);
+}
+void RocketBgfxTextureAtlas::resetSkyline(Page & page) const {
+    page.skyline.clear();
+    page.skyline.push_back({ 0, 0, _pageSize });
+}
+// Bottom-left heuristic: pick the spot that keeps the rect lowest, then the narrowest skyline segment under it.
+bool RocketBgfxTextureAtlas::findPosition(const Page & page, uint16_t width, uint16_t height, uint16_t & x, uint16_t & y, size_t & node) const {
+    uint32_t bestTop = UINT32_MAX;
+    uint32_t bestWidth = UINT32_MAX;
+
+    for (size_t i = 0; i < page.skyline.size(); ++i) {
+        const uint16_t left = page.skyline[i].x;
+        if (left + width > _pageSize)
+            break;
+
+        // The rect rests on the highest node it spans
+        uint16_t top = 0;
+        uint32_t spanned = 0;
+        for (size_t j = i; spanned < width; ++j) {
+            top = std::max(top, page.skyline[j].y);
+            spanned += page.skyline[j].width;
+        }
+        if (top + height > _pageSize)
+            continue;
+
+        if (top + height < bestTop || (top + height == bestTop && page.skyline[i].width < bestWidth)) {
+            bestTop = top + height;
+            bestWidth = page.skyline[i].width;
+            x = left;
+            y = top;
+            node = i;
+        }
+    }
+    return bestTop != UINT32_MAX;
+}
+// Raise the skyline over [x, x + width) to the top of the new rect, trimming or removing the nodes it covers.
+void RocketBgfxTextureAtlas::insertNode(Page & page, size_t node, uint16_t x, uint16_t y, uint16_t width, uint16_t height) const {
+    page.skyline.insert(page.skyline.begin() + node, SkylineNode{ x, static_cast<uint16_t>(y + height), width });
+
+    for (size_t i = node + 1; i < page.skyline.size(); ) {
+        SkylineNode & current = page.skyline[i];
+        const SkylineNode & previous = page.skyline[i - 1];
+        const uint16_t previousEnd = previous.x + previous.width;
+        if (current.x >= previousEnd)
+            break;
+
+        const uint16_t shrink = previousEnd - current.x;
+        if (current.width <= shrink) {
+            page.skyline.erase(page.skyline.begin() + i);
+            continue;
+        }
+        current.x += shrink;
+        current.width -= shrink;
+        break;
+    }
+
+    // Merge neighbours at the same height to keep the skyline short
+    for (size_t i = 0; i + 1 < page.skyline.size(); ) {
+        if (page.skyline[i].y == page.skyline[i + 1].y) {
+            page.skyline[i].width += page.skyline[i + 1].width;
+            page.skyline.erase(page.skyline.begin() + i + 1);
+        }
+        else {
+            ++i;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <bgfx.h>
+#include <cstddef>
+#include <vector>
+
+// Packs small RGBA8 images into shared texture pages so that glyph pages, icons and decorator images stop forcing
+// texture switches between draws. Pages are filled with a bottom-left skyline packer; each image is surrounded by
+// a transparent padding border so neighbours never bleed into each other, and uploaded with a partial
+// updateTexture2D. The skyline cannot reclaim holes, so a page is only recycled once every image on it is released.
+class RocketBgfxTextureAtlas
+{
+public:
+    struct Region {
+        uint16_t            page;
+        uint16_t            x, y, width, height;    // texels, excluding padding
+        bgfx::TextureHandle texture;
+        float               u0, v0, u1, v1;         // normalized bounds within the page
+
+        // Remap a UV in the image's own [0,1] space into the page. Out of range UVs are clamped, which matches the
+        // clamped sampling standalone textures get instead of reading the neighbouring images.
+        float mapU(float u) const noexcept { return u0 + clamp01(u) * (u1 - u0); }
+        float mapV(float v) const noexcept { return v0 + clamp01(v) * (v1 - v0); }
+
+    private:
+        static float clamp01(float value) noexcept { return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value); }
+    };
+
+    struct Stats {
+        uint32_t pages;
+        uint32_t liveRegions;
+        uint64_t pageArea;          // texels across all pages
+        uint64_t usedArea;          // texels below the skylines, i.e. no longer available to the packer
+        uint64_t liveArea;          // texels (with padding) belonging to images that are still alive
+        uint64_t bytesUploaded;     // total texel bytes written into the pages
+
+        float occupancy() const noexcept { return pageArea ? float(liveArea) / float(pageArea) : 0.0f; }
+        // Share of the consumed space that is dead: released images and skyline gaps that can't be reused yet
+        float fragmentation() const noexcept { return usedArea ? 1.0f - float(liveArea) / float(usedArea) : 0.0f; }
+    };
+
+    RocketBgfxTextureAtlas(uint16_t pageSize = 1024, uint16_t maxImageSize = 256, uint16_t padding = 1);
+    ~RocketBgfxTextureAtlas();
+
+    /// Whether an image is small enough to be packed, larger ones should get their own texture
+    bool fits(int width, int height) const noexcept;
+
+    /// Pack and upload an RGBA8 image. Returns false if it does not fit.
+    /// A null image reserves the region and clears it to transparent, to be filled in later with upload().
+    bool allocate(uint16_t width, uint16_t height, const uint8_t * rgba, Region & region);
+    void upload(const Region & region, const uint8_t * rgba);
+    void release(const Region & region);
+
+    Stats getStats() const noexcept;
+
+private:
+    struct SkylineNode {
+        uint16_t x, y, width;
+    };
+
+    struct Page {
+        bgfx::TextureHandle      texture;
+        std::vector<SkylineNode> skyline;
+        uint32_t                 liveRegions;
+        uint64_t                 liveArea;
+    };
+
+    void createPage();
+    void resetSkyline(Page & page) const;
+    bool findPosition(const Page & page, uint16_t width, uint16_t height, uint16_t & x, uint16_t & y, size_t & node) const;
+    void insertNode(Page & page, size_t node, uint16_t x, uint16_t y, uint16_t width, uint16_t height) const;
+
+    RocketBgfxTextureAtlas(const RocketBgfxTextureAtlas&) = delete; // non construction-copyable
+    RocketBgfxTextureAtlas& operator=(const RocketBgfxTextureAtlas&) = delete; // non copyable
+
+    uint16_t          _pageSize;
+    uint16_t          _maxImageSize;
+    uint16_t          _padding;
+    std::vector<Page> _pages;
+    uint64_t          _bytesUploaded;
+};
@@ -0,0 +1,236 @@
+#include "RocketBgfxTextureContainer.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+    const uint8_t KTX_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+    const uint32_t KTX_ENDIANNESS = 0x04030201;
+    const size_t KTX_HEADER_SIZE = 64;
+
+    const size_t DDS_HEADER_SIZE = 4 + 124;        // magic and DDS_HEADER
+    const size_t DDS_DX10_HEADER_SIZE = 20;
+    const uint32_t DDPF_FOURCC = 0x4;
+    const uint32_t DDPF_RGB = 0x40;
+    const uint32_t DDSCAPS2_CUBEMAP = 0x200;
+    const uint32_t DDSCAPS2_VOLUME = 0x200000;
+
+    // The GL internal formats and DXGI formats we map onto bgfx's
+    const uint32_t GL_RGBA8 = 0x8058;
+    const uint32_t GL_COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;
+    const uint32_t GL_COMPRESSED_RGBA_S3TC_DXT1 = 0x83F1;
+    const uint32_t GL_COMPRESSED_RGBA_S3TC_DXT3 = 0x83F2;
+    const uint32_t GL_COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+    const uint32_t GL_COMPRESSED_RGBA_BPTC_UNORM = 0x8E8C;
+    const uint32_t GL_COMPRESSED_RGB8_ETC2 = 0x9274;
+    const uint32_t GL_COMPRESSED_RGBA8_ETC2_EAC = 0x9278;
+    const uint32_t DXGI_FORMAT_R8G8B8A8_UNORM = 28;
+    const uint32_t DXGI_FORMAT_BC1_UNORM = 71;
+    const uint32_t DXGI_FORMAT_BC2_UNORM = 74;
+    const uint32_t DXGI_FORMAT_BC3_UNORM = 77;
+    const uint32_t DXGI_FORMAT_B8G8R8A8_UNORM = 87;
+    const uint32_t DXGI_FORMAT_BC7_UNORM = 98;
+
+    inline uint32_t read32(const uint8_t * p) noexcept {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    inline uint32_t swap32(uint32_t value) noexcept {
+        return (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+    }
+    inline uint32_t fourCC(char a, char b, char c, char d) noexcept {
+        return uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) | (uint32_t(uint8_t(d)) << 24);
+    }
+    bool isCompressed(bgfx::TextureFormat::Enum format) noexcept {
+        return format != bgfx::TextureFormat::RGBA8 && format != bgfx::TextureFormat::BGRA8;
+    }
+    // Bytes per 4x4 block of a compressed format, or per texel of an uncompressed one
+    uint32_t unitBytes(bgfx::TextureFormat::Enum format) noexcept {
+        switch (format) {
+        case bgfx::TextureFormat::BC1:
+        case bgfx::TextureFormat::ETC2:
+            return 8;
+        case bgfx::TextureFormat::BC2:
+        case bgfx::TextureFormat::BC3:
+        case bgfx::TextureFormat::BC7:
+        case bgfx::TextureFormat::ETC2A:
+            return 16;
+        default:
+            return 4;
+        }
+    }
+    bool checkSize(uint32_t width, uint32_t height, uint32_t mips, RocketBgfxTextureContainer::Info & info, std::string & error) {
+        if (width < 1 || height < 1 || width > UINT16_MAX || height > UINT16_MAX) {
+            error = "TEXTURE_CONTAINER_BAD_SIZE";
+            return false;
+        }
+        mips = std::max(mips, 1u);
+        if (mips > RocketBgfxTextureContainer::fullMipCount(width, height)) {
+            error = "TEXTURE_CONTAINER_BAD_MIP_COUNT";
+            return false;
+        }
+        info.width = static_cast<uint16_t>(width);
+        info.height = static_cast<uint16_t>(height);
+        info.mips = static_cast<uint8_t>(mips);
+        info.storageSize = RocketBgfxTextureContainer::storageSize(info.format, width, height, mips);
+        return true;
+    }
+}
+
+bool RocketBgfxTextureContainer::isContainerPath(const std::string & path) {
+    const size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos)
+        return false;
+
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return char(std::tolower(uint8_t(c))); });
+    return extension == "ktx" || extension == "dds";
+}
+uint32_t RocketBgfxTextureContainer::fullMipCount(uint32_t width, uint32_t height) noexcept {
+    uint32_t mips = 1;
+    for (uint32_t side = std::max(width, height); side > 1; side >>= 1) {
+        mips++;
+    }
+    return mips;
+}
+uint32_t RocketBgfxTextureContainer::storageSize(bgfx::TextureFormat::Enum format, uint32_t width, uint32_t height, uint32_t mips) noexcept {
+    uint32_t bytes = 0;
+    for (uint32_t mip = 0; mip < mips; ++mip) {
+        const uint32_t w = std::max(width >> mip, 1u);
+        const uint32_t h = std::max(height >> mip, 1u);
+        bytes += isCompressed(format)
+            ? ((w + 3) / 4) * ((h + 3) / 4) * unitBytes(format)
+            : w * h * unitBytes(format);
+    }
+    return bytes;
+}
+bool RocketBgfxTextureContainer::parse(const uint8_t * data, size_t size, Info & info, std::string & error) {
+    if (size >= sizeof(KTX_IDENTIFIER) && std::memcmp(data, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) == 0)
+        return parseKtx(data, size, info, error);
+    if (size >= 4 && read32(data) == fourCC('D', 'D', 'S', ' '))
+        return parseDds(data, size, info, error);
+
+    error = "UNKNOWN_TEXTURE_CONTAINER";
+    return false;
+}
+// Every mip level is stored as its byte count followed by the texels, so walking them also checks the file is whole
+bool RocketBgfxTextureContainer::parseKtx(const uint8_t * data, size_t size, Info & info, std::string & error) {
+    if (size < KTX_HEADER_SIZE) {
+        error = "TEXTURE_CONTAINER_TRUNCATED";
+        return false;
+    }
+    const bool swapped = read32(data + 12) != KTX_ENDIANNESS;
+    auto field = [data, swapped](size_t index) { const uint32_t value = read32(data + 16 + index * 4); return swapped ? swap32(value) : value; };
+    const uint32_t glInternalFormat = field(3);
+    const uint32_t width = field(5), height = field(6), depth = field(7);
+    const uint32_t arrayElements = field(8), faces = field(9), mips = field(10);
+    const uint32_t keyValueBytes = field(11);
+
+    if (depth > 1 || arrayElements > 0 || faces != 1) {
+        error = "TEXTURE_CONTAINER_NOT_2D";
+        return false;
+    }
+    switch (glInternalFormat) {
+    case GL_COMPRESSED_RGB_S3TC_DXT1:
+    case GL_COMPRESSED_RGBA_S3TC_DXT1:      info.format = bgfx::TextureFormat::BC1; break;
+    case GL_COMPRESSED_RGBA_S3TC_DXT3:      info.format = bgfx::TextureFormat::BC2; break;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5:      info.format = bgfx::TextureFormat::BC3; break;
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:     info.format = bgfx::TextureFormat::BC7; break;
+    case GL_COMPRESSED_RGB8_ETC2:           info.format = bgfx::TextureFormat::ETC2; break;
+    case GL_COMPRESSED_RGBA8_ETC2_EAC:      info.format = bgfx::TextureFormat::ETC2A; break;
+    case GL_RGBA8:                          info.format = bgfx::TextureFormat::RGBA8; break;
+    default:
+        error = "UNSUPPORTED_TEXTURE_FORMAT";
+        return false;
+    }
+    if (!checkSize(width, height, mips, info, error))
+        return false;
+
+    size_t offset = KTX_HEADER_SIZE + size_t(keyValueBytes);
+    for (uint32_t mip = 0; mip < info.mips; ++mip) {
+        if (offset + 4 > size) {
+            error = "TEXTURE_CONTAINER_TRUNCATED";
+            return false;
+        }
+        const uint32_t levelBytes = swapped ? swap32(read32(data + offset)) : read32(data + offset);
+        if (levelBytes != storageSize(info.format, std::max(width >> mip, 1u), std::max(height >> mip, 1u), 1)) {
+            error = "TEXTURE_CONTAINER_BAD_MIP_SIZE";
+            return false;
+        }
+        if (offset + 4 + levelBytes > size) {
+            error = "TEXTURE_CONTAINER_TRUNCATED";
+            return false;
+        }
+        offset += 4 + ((size_t(levelBytes) + 3) & ~size_t(3));
+    }
+    return true;
+}
+bool RocketBgfxTextureContainer::parseDds(const uint8_t * data, size_t size, Info & info, std::string & error) {
+    if (size < DDS_HEADER_SIZE) {
+        error = "TEXTURE_CONTAINER_TRUNCATED";
+        return false;
+    }
+    const uint8_t * header = data + 4;
+    const uint32_t height = read32(header + 8), width = read32(header + 12), depth = read32(header + 20);
+    const uint32_t mips = read32(header + 24);
+    const uint8_t * pixelFormat = header + 72;
+    const uint32_t pixelFlags = read32(pixelFormat + 4), pixelFourCC = read32(pixelFormat + 8);
+    const uint32_t bitCount = read32(pixelFormat + 12), redMask = read32(pixelFormat + 16);
+    const uint32_t caps2 = read32(header + 108);
+
+    if (depth > 1 || (caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME))) {
+        error = "TEXTURE_CONTAINER_NOT_2D";
+        return false;
+    }
+
+    size_t dataOffset = DDS_HEADER_SIZE;
+    bool known = true;
+    if ((pixelFlags & DDPF_FOURCC) && pixelFourCC == fourCC('D', 'X', '1', '0')) {
+        if (size < DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE) {
+            error = "TEXTURE_CONTAINER_TRUNCATED";
+            return false;
+        }
+        const uint8_t * extended = data + DDS_HEADER_SIZE;
+        const uint32_t arraySize = read32(extended + 12);
+        if (arraySize > 1) {
+            error = "TEXTURE_CONTAINER_NOT_2D";
+            return false;
+        }
+        dataOffset += DDS_DX10_HEADER_SIZE;
+        switch (read32(extended)) {
+        case DXGI_FORMAT_BC1_UNORM:         info.format = bgfx::TextureFormat::BC1; break;
+        case DXGI_FORMAT_BC2_UNORM:         info.format = bgfx::TextureFormat::BC2; break;
+        case DXGI_FORMAT_BC3_UNORM:         info.format = bgfx::TextureFormat::BC3; break;
+        case DXGI_FORMAT_BC7_UNORM:         info.format = bgfx::TextureFormat::BC7; break;
+        case DXGI_FORMAT_R8G8B8A8_UNORM:    info.format = bgfx::TextureFormat::RGBA8; break;
+        case DXGI_FORMAT_B8G8R8A8_UNORM:    info.format = bgfx::TextureFormat::BGRA8; break;
+        default:                            known = false; break;
+        }
+    }
+    else if (pixelFlags & DDPF_FOURCC) {
+        if (pixelFourCC == fourCC('D', 'X', 'T', '1'))      info.format = bgfx::TextureFormat::BC1;
+        else if (pixelFourCC == fourCC('D', 'X', 'T', '3')) info.format = bgfx::TextureFormat::BC2;
+        else if (pixelFourCC == fourCC('D', 'X', 'T', '5')) info.format = bgfx::TextureFormat::BC3;
+        else known = false;
+    }
+    else if ((pixelFlags & DDPF_RGB) && bitCount == 32) {
+        info.format = redMask == 0x000000FF ? bgfx::TextureFormat::RGBA8 : bgfx::TextureFormat::BGRA8;
+    }
+    else {
+        known = false;
+    }
+    if (!known) {
+        error = "UNSUPPORTED_TEXTURE_FORMAT";
+        return false;
+    }
+
+    if (!checkSize(width, height, mips, info, error))
+        return false;
+    if (dataOffset + info.storageSize > size) {
+        error = "TEXTURE_CONTAINER_TRUNCATED";
+        return false;
+    }
+    return true;
+}
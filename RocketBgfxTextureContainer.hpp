@@ -0,0 +1,37 @@
+#pragma once
+
+#include <bgfx.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Reads the header of a KTX (version 1) or DDS file: enough to tell Rocket the image size and check that bgfx can create
+// the texture from the file as it is. Only single 2D images are accepted, with or without a mip chain, in the formats
+// UI art is shipped in: BC1/BC2/BC3/BC7, ETC2 and uncompressed RGBA8/BGRA8.
+class RocketBgfxTextureContainer
+{
+public:
+    struct Info {
+        bgfx::TextureFormat::Enum format;
+        uint16_t                  width, height;
+        uint8_t                   mips;
+        uint32_t                  storageSize;  // texel data of all mips, as it will sit in GPU memory
+    };
+
+    /// Whether a LoadTexture source names a container rather than an image for stb_image (by its extension)
+    static bool isContainerPath(const std::string & path);
+
+    /// Parse and validate a whole container file. On failure error says why, in LoadTexture's failure reason style.
+    static bool parse(const uint8_t * data, size_t size, Info & info, std::string & error);
+
+    /// Bytes of a mip chain of the format, compressed formats round every level up to whole 4x4 blocks
+    static uint32_t storageSize(bgfx::TextureFormat::Enum format, uint32_t width, uint32_t height, uint32_t mips) noexcept;
+
+    /// Mips of a full chain down to 1x1
+    static uint32_t fullMipCount(uint32_t width, uint32_t height) noexcept;
+
+private:
+    static bool parseKtx(const uint8_t * data, size_t size, Info & info, std::string & error);
+    static bool parseDds(const uint8_t * data, size_t size, Info & info, std::string & error);
+};
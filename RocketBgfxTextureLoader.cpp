@@ -0,0 +1,100 @@
+#include "RocketBgfxTextureLoader.hpp"
+
+#include <chrono>
+#include <stb_image.h>
+
+RocketBgfxTextureLoader::RocketBgfxTextureLoader(unsigned threads)
+    : _nextTicket(1), _inFlight(0), _quit(false)
+{
+    if (threads < 1)
+        threads = 1;
+
+    for (unsigned i = 0; i < threads; ++i) {
+        _threads.emplace_back(&RocketBgfxTextureLoader::worker, this);
+    }
+}
+// Unstarted jobs are dropped, and anything decoded but never collected is freed here.
+RocketBgfxTextureLoader::~RocketBgfxTextureLoader() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _quit = true;
+        _jobs.clear();
+    }
+    _wake.notify_all();
+
+    for (auto & thread : _threads) {
+        thread.join();
+    }
+
+    for (auto & result : _results) {
+        freePixels(result.pixels);
+    }
+}
+uint32_t RocketBgfxTextureLoader::request(const std::string & source) {
+    uint32_t ticket;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ticket = _nextTicket++;
+        if (_nextTicket == 0)
+            _nextTicket = 1;
+
+        _jobs.push_back({ ticket, source });
+        _inFlight++;
+    }
+    _wake.notify_one();
+    return ticket;
+}
+bool RocketBgfxTextureLoader::poll(Result & result) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_results.empty())
+        return false;
+
+    result = std::move(_results.front());
+    _results.pop_front();
+    _inFlight--;
+    return true;
+}
+size_t RocketBgfxTextureLoader::pending() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _inFlight;
+}
+void RocketBgfxTextureLoader::freePixels(unsigned char * pixels) {
+    if (pixels) {
+        stbi_image_free(pixels);
+    }
+}
+void RocketBgfxTextureLoader::worker() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [this] { return _quit || !_jobs.empty(); });
+            if (_quit)
+                return;
+
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+
+        Result result;
+        result.ticket = job.ticket;
+        result.source = std::move(job.source);
+        result.width = 0;
+        result.height = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        int channels = 0;
+        result.pixels = stbi_load(result.source.c_str(), &result.width, &result.height, &channels, STBI_rgb_alpha);
+        if (!(result.pixels && result.width && result.height)) {
+            // stbi_failure_reason() is shared between threads, so this is best effort
+            const char * reason = stbi_failure_reason();
+            result.error = reason ? reason : "FAILED_TO_LOAD_IMAGE_FROM_FILE";
+            freePixels(result.pixels);
+            result.pixels = nullptr;
+        }
+        result.decodeNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _results.push_back(std::move(result));
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A small pool of worker threads that decode image files to RGBA8 off the render thread.
+// request() queues a file and returns a ticket straight away; the owner collects finished decodes with poll() from
+// its own thread and takes ownership of the pixels, which must be given back with freePixels().
+class RocketBgfxTextureLoader
+{
+public:
+    struct Result {
+        uint32_t        ticket;
+        std::string     source;
+        unsigned char * pixels;         // nullptr if decoding failed
+        int             width, height;
+        std::string     error;
+        uint64_t        decodeNs;       // time the worker spent on it
+    };
+
+    explicit RocketBgfxTextureLoader(unsigned threads = 2);
+    ~RocketBgfxTextureLoader();
+
+    uint32_t request(const std::string & source);
+
+    /// Pop one finished decode, returns false when there is none
+    bool poll(Result & result);
+
+    /// Number of requests that have not been collected with poll() yet
+    size_t pending() const;
+
+    static void freePixels(unsigned char * pixels);
+
+private:
+    struct Job {
+        uint32_t    ticket;
+        std::string source;
+    };
+
+    void worker();
+
+    RocketBgfxTextureLoader(const RocketBgfxTextureLoader&) = delete; // non construction-copyable
+    RocketBgfxTextureLoader& operator=(const RocketBgfxTextureLoader&) = delete; // non copyable
+
+    mutable std::mutex       _mutex;
+    std::condition_variable  _wake;
+    std::deque<Job>          _jobs;
+    std::deque<Result>       _results;
+    std::vector<std::thread> _threads;
+    uint32_t                 _nextTicket;
+    size_t                   _inFlight;
+    bool                     _quit;
+};
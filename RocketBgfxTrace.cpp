@@ -0,0 +1,96 @@
+#include "RocketBgfxTrace.hpp"
+
+#include <chrono>
+#include <functional>
+#include <thread>
+
+namespace {
+    uint32_t currentThread() {
+        return static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    }
+    // Names are expected to be identifiers, only the characters JSON needs escaped are handled
+    void writeString(std::ofstream & file, const char * text) {
+        file << '"';
+        for (; *text; ++text) {
+            if (*text == '"' || *text == '\\')
+                file << '\\';
+            file << *text;
+        }
+        file << '"';
+    }
+    // Trace timestamps are microseconds, written with nanosecond decimals
+    void writeMicroseconds(std::ofstream & file, uint64_t ns) {
+        const uint64_t fraction = ns % 1000;
+        file << ns / 1000 << '.' << (fraction < 100 ? (fraction < 10 ? "00" : "0") : "") << fraction;
+    }
+}
+
+RocketBgfxTrace::RocketBgfxTrace(const std::string & path, size_t bufferedEvents)
+    : _file(path, std::ios::out | std::ios::trunc), _bufferedEvents(bufferedEvents), _firstEvent(true)
+{
+    if (_file.is_open()) {
+        _file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    }
+    _events.reserve(_bufferedEvents);
+}
+RocketBgfxTrace::~RocketBgfxTrace() {
+    close();
+}
+uint64_t RocketBgfxTrace::now() noexcept {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+void RocketBgfxTrace::complete(const char * name, uint64_t startNs, uint64_t durationNs) {
+    push({ name, nullptr, 'X', currentThread(), startNs, durationNs, 0.0 });
+}
+void RocketBgfxTrace::counter(const char * name, const char * series, double value, uint64_t timeNs) {
+    push({ name, series, 'C', currentThread(), timeNs, 0, value });
+}
+void RocketBgfxTrace::flush() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    write();
+    _file.flush();
+}
+void RocketBgfxTrace::close() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_file.is_open())
+        return;
+
+    write();
+    _file << "]}\n";
+    _file.close();
+}
+void RocketBgfxTrace::push(const Event & event) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_file.is_open())
+        return;
+
+    _events.push_back(event);
+    if (_events.size() >= _bufferedEvents) {
+        write();
+    }
+}
+// Called with the mutex held
+void RocketBgfxTrace::write() {
+    for (const auto & event : _events) {
+        _file << (_firstEvent ? "\n" : ",\n");
+        _firstEvent = false;
+
+        _file << "{\"name\":";
+        writeString(_file, event.name);
+        _file << ",\"ph\":\"" << event.phase << "\",\"pid\":1,\"tid\":" << event.thread
+              << ",\"ts\":";
+        writeMicroseconds(_file, event.timeNs);
+        if (event.phase == 'X') {
+            _file << ",\"dur\":";
+            writeMicroseconds(_file, event.durationNs);
+        }
+        else {
+            _file << ",\"args\":{";
+            writeString(_file, event.series);
+            _file << ':' << event.value << '}';
+        }
+        _file << '}';
+    }
+    _events.clear();
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Writes Chrome trace-event JSON (chrome://tracing, Perfetto) for the UI's CPU work.
+// Timestamps are steady_clock microseconds, so events line up with any other tracer on the same clock. Events are
+// buffered and written out in batches; the file is a valid trace once the writer is destroyed or closed. Event names
+// are not copied and must be string literals or otherwise outlive the writer. All calls are thread-safe.
+class RocketBgfxTrace
+{
+public:
+    explicit RocketBgfxTrace(const std::string & path, size_t bufferedEvents = 4096);
+    ~RocketBgfxTrace();
+
+    bool isOpen() const noexcept { return _file.is_open(); }
+
+    /// Nanoseconds on the trace clock
+    static uint64_t now() noexcept;
+
+    /// A span of work on the calling thread
+    void complete(const char * name, uint64_t startNs, uint64_t durationNs);
+    /// A sample of a named counter track
+    void counter(const char * name, const char * series, double value, uint64_t timeNs);
+
+    void flush();
+    void close();
+
+private:
+    struct Event {
+        const char * name;
+        const char * series;    // counters only
+        char         phase;
+        uint32_t     thread;
+        uint64_t     timeNs;
+        uint64_t     durationNs;
+        double       value;
+    };
+
+    void push(const Event & event);
+    void write();
+
+    RocketBgfxTrace(const RocketBgfxTrace&) = delete; // non construction-copyable
+    RocketBgfxTrace& operator=(const RocketBgfxTrace&) = delete; // non copyable
+
+    std::mutex         _mutex;
+    std::ofstream      _file;
+    std::vector<Event> _events;
+    size_t             _bufferedEvents;
+    bool               _firstEvent;
+};
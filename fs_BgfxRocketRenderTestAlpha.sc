@@ -0,0 +1,11 @@
+$input v_texcoord0, v_color0
+
+#include "..\examples\common\common.sh"
+
+// Single-channel glyph pages: the red channel holds the alpha of a white texel, the color is the vertex color's.
+SAMPLER2D(s_texture0, 0);
+
+void main()
+{
+	gl_FragColor = vec4(v_color0.rgb, v_color0.a * texture2D( s_texture0, v_texcoord0 ).r);
+}
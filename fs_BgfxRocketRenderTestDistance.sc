@@ -0,0 +1,36 @@
+$input v_texcoord0, v_color0
+
+#include "..\examples\common\common.sh"
+
+// Distance field glyph pages (RocketBgfxDistanceField): the red channel is 0.5 on the glyph's edge and rises towards
+// its inside. The edge is antialiased over one screen pixel whatever the scale, see RocketBgfxSubmitter::DistanceFieldStyle.
+SAMPLER2D(s_texture0, 0);
+
+uniform vec4 u_distanceParams;      // softness, outline width, shadow offset in screen pixels (zw)
+uniform vec4 u_outlineColor;
+uniform vec4 u_shadowColor;
+
+float coverage(float distance, float edge, float width)
+{
+	return smoothstep(edge - width, edge + width, distance);
+}
+
+void main()
+{
+	float distance = texture2D(s_texture0, v_texcoord0).x;
+	float width = max(fwidth(distance) * 0.5 * u_distanceParams.x, 1.0 / 255.0);
+
+	float fill = coverage(distance, 0.5, width);
+	float outline = coverage(distance, 0.5 - u_distanceParams.y, width);
+	vec4 body = mix(vec4(u_outlineColor.rgb, u_outlineColor.a * v_color0.a), v_color0, fill / max(outline, 1.0 / 255.0) );
+	body.a *= outline;
+
+	// Screen space offset into texture space, so the shadow keeps its distance at every scale
+	vec2 shadowUv = v_texcoord0 - dFdx(v_texcoord0) * u_distanceParams.z - dFdy(v_texcoord0) * u_distanceParams.w;
+	float shadowDistance = texture2D(s_texture0, shadowUv).x;
+	float shadow = coverage(shadowDistance, 0.5 - u_distanceParams.y, width) * u_shadowColor.a * v_color0.a;
+
+	float alpha = body.a + shadow * (1.0 - body.a);
+	vec3 color = (body.rgb * body.a + u_shadowColor.rgb * shadow * (1.0 - body.a) ) / max(alpha, 1.0 / 255.0);
+	gl_FragColor = vec4(color, alpha);
+}
@@ -3,9 +3,16 @@ $output v_texcoord0, v_color0
 
 #include "..\examples\common\common.sh"
 
+// Positions arrive as snorm16 fixed point with 4 steps per pixel (RocketBgfxInterface::POSITION_SUBPIXELS),
+// UVs as snorm16 already normalized to [0, 1].
+#define POSITION_SCALE (32767.0 / 4.0)
+
+// Draw origin in pixels (xy), compiled geometry is positioned with this instead of a model matrix
+uniform vec4 u_translation;
+
 void main()
 {
-    vec2 p_position = a_position;
+    vec2 p_position = a_position * POSITION_SCALE + u_translation.xy;
     gl_Position = mul(u_modelViewProj, vec4(p_position, 0.0, 1.0) );
     v_color0 = a_color0;
     v_texcoord0 = a_texcoord0;
@@ -0,0 +1,16 @@
+$input a_position, a_color0, a_texcoord0, i_data0
+$output v_texcoord0, v_color0
+
+#include "..\examples\common\common.sh"
+
+// vs_BgfxRocketRenderTest for instanced compiled geometry: each instance's draw origin in pixels arrives in the
+// xy of its instance data (RocketBgfxInterface::INSTANCE_STRIDE bytes) instead of the u_translation uniform.
+#define POSITION_SCALE (32767.0 / 4.0)
+
+void main()
+{
+    vec2 p_position = a_position * POSITION_SCALE + i_data0.xy;
+    gl_Position = mul(u_modelViewProj, vec4(p_position, 0.0, 1.0) );
+    v_color0 = a_color0;
+    v_texcoord0 = a_texcoord0;
+}